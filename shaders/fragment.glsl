@@ -1,26 +1,69 @@
 #version 330 core
 
-flat in vec3 NormalVS;      // Facet normal in view space (flat = uniform per facet)
-flat in vec3 FaceCenterVS;  // Facet center in view space (flat = uniform per facet)
+in vec3 PositionVS;
 
 out vec4 FragColor;
 
-uniform mat4 view;
-uniform vec3 lightDirection;
+// See vertex.glsl
+layout(std140) uniform FrameUniforms {
+    mat4 projection;
+    mat4 view;
+    mat4 model;
+    mat4 modelView;
+    mat3 normalMatrix;
+    vec3 lightDirectionVS;
+};
+
+// Flat shading per facet (not per triangle) hides the triangulation. The facet
+// of the triangle being drawn is found from its index, primitiveBase + gl_PrimitiveID
+// (the renderer draws the visible triangle ranges one at a time):
+//   facetLookup 1: facetData is in triangle order
+//   facetLookup 2: through triangleFacets (triangle -> facet)
+//   facetLookup 0: no facet data; use the triangle's own normal
+uniform samplerBuffer facetData;        // 2 texels per facet: normal, center
+uniform usamplerBuffer triangleFacets;
+uniform int facetLookup;
+uniform int primitiveBase;              // first triangle of the current draw
+// Quantized meshes (RGBA16 facet data): octahedral normals, and centers stored
+// like the vertex positions
+uniform bool octahedralNormals;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+vec3 octahedralDecode(vec2 e)
+{
+    vec2 f = e * 2.0 - 1.0;
+    vec3 n = vec3(f, 1.0 - abs(f.x) - abs(f.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.y += (n.y >= 0.0) ? -t : t;
+    return n;
+}
 
 void main()
 {
-    // Light direction in view space
-    vec3 lightDirVS = normalize((view * vec4(lightDirection, 0.0)).xyz);
-    vec3 norm = normalize(NormalVS);
-    
+    vec3 norm;
+    vec3 faceCenterVS;
+    if (facetLookup == 0) {
+        norm = normalize(cross(dFdx(PositionVS), dFdy(PositionVS)));
+        faceCenterVS = PositionVS;
+    } else {
+        int triangle = primitiveBase + gl_PrimitiveID;
+        int facet = (facetLookup == 1) ? triangle : int(texelFetch(triangleFacets, triangle).r);
+        vec4 normalTexel = texelFetch(facetData, 2 * facet);
+        vec3 facetNormal = octahedralNormals ? octahedralDecode(normalTexel.xy) : normalTexel.xyz;
+        vec3 facetCenter = positionOffset + texelFetch(facetData, 2 * facet + 1).xyz * positionScale;
+        norm = normalize(normalMatrix * facetNormal);
+        faceCenterVS = vec3(modelView * vec4(facetCenter, 1.0));
+    }
+
     // Ambient + Diffuse
     float ambient = 0.45;
-    float diffuse = max(dot(norm, lightDirVS), 0.0);
+    float diffuse = max(dot(norm, lightDirectionVS), 0.0);
     
     // Specular
-    vec3 viewDir = normalize(-FaceCenterVS);
-    vec3 reflectDir = reflect(-lightDirVS, norm);
+    vec3 viewDir = normalize(-faceCenterVS);
+    vec3 reflectDir = reflect(-lightDirectionVS, norm);
     float specular = 0.45 * pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
     
     // Final color
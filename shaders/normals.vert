@@ -2,10 +2,19 @@
 
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 projection;
-uniform mat4 view;
-uniform mat4 model;
+// See vertex.glsl
+layout(std140) uniform FrameUniforms {
+    mat4 projection;
+    mat4 view;
+    mat4 model;
+    mat4 modelView;
+    mat3 normalMatrix;
+    vec3 lightDirectionVS;
+};
+// Dequantization, see vertex.glsl (identity for the float normal lines)
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
 
 void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * modelView * vec4(positionOffset + aPos * positionScale, 1.0);
 }
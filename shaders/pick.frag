@@ -0,0 +1,11 @@
+#version 330 core
+
+// Triangle ID buffer for GPU picking (Renderer::requestPick). 0 means no
+// triangle, so every triangle writes its index + 1.
+uniform int primitiveBase;              // first triangle of the current draw
+
+out uint TriangleId;
+
+void main() {
+    TriangleId = uint(primitiveBase + gl_PrimitiveID) + 1u;
+}
@@ -1,26 +1,27 @@
 #version 330 core
 
 layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec3 aFacetCenter;
 
-flat out vec3 NormalVS;        // Transform to view space here
-flat out vec3 FaceCenterVS;    // Transform to view space here
+out vec3 PositionVS;    // View-space position (for the per-triangle shading fallback)
 
-uniform mat4 projection;
-uniform mat4 view;
-uniform mat4 model;
+// Per-frame camera and lighting state, shared by every program (std140 layout
+// must match Renderer::FrameUniforms)
+layout(std140) uniform FrameUniforms {
+    mat4 projection;
+    mat4 view;
+    mat4 model;
+    mat4 modelView;         // view * model
+    mat3 normalMatrix;      // model normals to view space
+    vec3 lightDirectionVS;  // unit, view space
+};
+// Quantized meshes store positions as normalized 16-bit offsets in the bounding
+// box; float buffers use offset 0 and scale 1
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
 
 void main()
 {
-    vec4 worldPosition = model * vec4(aPos, 1.0);
-    
-    // Transform normal to view space (do expensive operation once per vertex, not per triangle)
-    vec3 normalWorld = mat3(transpose(inverse(model))) * aNormal;
-    NormalVS = normalize((view * vec4(normalWorld, 0.0)).xyz);
-    
-    // Transform facet center to view space
-    FaceCenterVS = vec3(view * model * vec4(aFacetCenter, 1.0));
-    
-    gl_Position = projection * view * worldPosition;
+    vec4 positionVS = modelView * vec4(positionOffset + aPos * positionScale, 1.0);
+    PositionVS = positionVS.xyz;
+    gl_Position = projection * positionVS;
 }
@@ -0,0 +1,52 @@
+#include "AsyncMeshLoader.h"
+#include <iostream>
+#include <new>
+
+AsyncMeshLoader::~AsyncMeshLoader() {
+    m_progress.cancel();
+    wait();
+}
+
+void AsyncMeshLoader::start(const std::string& path, const GeometryLoadOptions& options,
+                            const MeshRenderOptions& renderOptions) {
+    // The progress object is shared with the worker, so the previous one must be gone first
+    m_progress.cancel();
+    wait();
+
+    m_progress.reset();
+    m_result.reset();
+    m_finished = false;
+    m_path = path;
+
+    m_worker = std::thread([this, path, options, renderOptions]() {
+        std::unique_ptr<MeshRenderData> data;
+        try {
+            std::unique_ptr<Mesh> mesh = GeometryLoader::load(path, options, &m_progress);
+            if (mesh && !m_progress.isCancelled()) {
+                data = Renderer::prepareMesh(std::move(mesh), renderOptions, &m_progress);
+            }
+        } catch (const std::bad_alloc&) {
+            std::cerr << "Out of memory while loading " << path << std::endl;
+            data.reset();
+        }
+        m_result = std::move(data);
+        m_finished.store(true, std::memory_order_release);
+    });
+}
+
+bool AsyncMeshLoader::poll(std::unique_ptr<MeshRenderData>& result) {
+    if (!m_worker.joinable() || !m_finished.load(std::memory_order_acquire)) {
+        return false;
+    }
+    m_worker.join();
+    result = m_progress.isCancelled() ? nullptr : std::move(m_result);
+    m_result.reset();
+    return true;
+}
+
+void AsyncMeshLoader::wait() {
+    if (m_worker.joinable()) {
+        m_worker.join();
+    }
+    m_result.reset();
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "GeometryLoader.h"
+#include "Renderer.h"
+#include "progress/AsyncProgress.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+// Loads a geometry file on a worker thread: parsing, welding, triangulation and
+// the renderer's CPU-side buffers (Renderer::prepareMesh) all happen off the
+// render thread, which only polls for the result and uploads it.
+// One load at a time; all methods must be called from the owning (UI) thread.
+class AsyncMeshLoader {
+public:
+    AsyncMeshLoader() = default;
+    ~AsyncMeshLoader();
+
+    AsyncMeshLoader(const AsyncMeshLoader&) = delete;
+    AsyncMeshLoader& operator=(const AsyncMeshLoader&) = delete;
+
+    // Start loading `path`, cancelling (and waiting for) any load in progress
+    void start(const std::string& path, const GeometryLoadOptions& options,
+               const MeshRenderOptions& renderOptions = MeshRenderOptions());
+
+    // Ask the running load to stop; poll() then reports it without a result
+    void cancel() { m_progress.cancel(); }
+
+    // True from start() until poll() has returned the outcome
+    bool isLoading() const { return m_worker.joinable(); }
+
+    // Returns false while the worker is still running. Otherwise joins it and
+    // hands over its result, which is nullptr if the load failed or was cancelled.
+    bool poll(std::unique_ptr<MeshRenderData>& result);
+
+    bool wasCancelled() const { return m_progress.isCancelled(); }
+    const AsyncProgress& progress() const { return m_progress; }
+    const std::string& path() const { return m_path; }
+
+private:
+    void wait();
+
+    std::thread m_worker;
+    AsyncProgress m_progress;
+    std::atomic<bool> m_finished{false};
+    std::unique_ptr<MeshRenderData> m_result; // written by the worker before m_finished is set
+    std::string m_path;
+};
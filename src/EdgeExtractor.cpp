@@ -0,0 +1,162 @@
+#include "EdgeExtractor.h"
+#include "MeshTriangulator.h"
+#include "MeshWelder.h"
+#include "ParallelSort.h"
+#include "progress/Progress_abstract.h"  // Include for mySTLviewer standalone compilation
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+// Key of edges that collapse to a point; sorts after every real edge
+constexpr uint64_t kCollapsedEdge = ~uint64_t(0);
+
+// One facet perimeter edge. Entries with equal keys are the same edge; from/to
+// are the facet's own vertex indices, which is what gets drawn.
+struct EdgeEntry {
+    uint64_t key;       // (min, max) of the end points' representative vertices
+    unsigned int facet;
+    unsigned int from;
+    unsigned int to;
+};
+
+inline bool operator<(const EdgeEntry& a, const EdgeEntry& b) {
+    if (a.key != b.key) return a.key < b.key;
+    if (a.facet != b.facet) return a.facet < b.facet;
+    return a.from != b.from ? a.from < b.from : a.to < b.to;
+}
+
+inline uint64_t edgeKey(unsigned int a, unsigned int b) {
+    if (a == b) return kCollapsedEdge;
+    return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+}
+
+} // namespace
+
+EdgeExtractor::Result EdgeExtractor::extract(Mesh& mesh, float featureAngleDegrees, Progress_abstract* progress) {
+    Result result;
+    mesh.edgeIndices.clear();
+    mesh.edgeClassOffsets.fill(0);
+    const size_t facetCount = mesh.facets.size();
+    if (facetCount == 0) {
+        return result;
+    }
+
+    if (progress) {
+        progress->setMessage("Extracting edges...");
+        progress->setProgress(0.0f);
+    }
+
+    // Coincident vertices count as one, so unwelded meshes share edges too
+    const std::vector<unsigned int> representative = MeshWelder::findRepresentatives(mesh);
+
+    // The perimeter edges of facet f go to entries[offsets[f] .. offsets[f + 1])
+    const std::vector<unsigned int>& offsets = mesh.facets.offsets;
+    std::vector<EdgeEntry> entries(mesh.facets.indices.size());
+    std::vector<glm::vec3> normals(facetCount);
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(static) if (facetCount > 100000)
+#endif
+    for (long long f = 0; f < static_cast<long long>(facetCount); ++f) {
+        const FacetView facet = mesh.facets[f];
+        EdgeEntry* out = entries.data() + offsets[f];
+        const size_t n = facet.size();
+        if (n < 3) { // Skip degenerate facets
+            for (size_t k = 0; k < n; ++k) {
+                out[k] = {kCollapsedEdge, static_cast<unsigned int>(f), 0, 0};
+            }
+            continue;
+        }
+        normals[f] = MeshTriangulator::facetNormal(mesh, facet);
+        for (size_t k = 0; k < n; ++k) {
+            const unsigned int from = facet[k];
+            const unsigned int to = facet[(k + 1) % n];
+            out[k] = {edgeKey(representative[from], representative[to]), static_cast<unsigned int>(f), from, to};
+        }
+    }
+
+    if (progress) progress->setProgress(0.3f);
+
+    // Sorting by key groups every edge with its neighbours, in facet order
+    parallelSort(entries, [](const EdgeEntry& a, const EdgeEntry& b) { return a < b; });
+    const size_t count = static_cast<size_t>(
+        std::partition_point(entries.begin(), entries.end(),
+                             [](const EdgeEntry& e) { return e.key != kCollapsedEdge; }) - entries.begin());
+    result.facetEdges = count;
+
+    if (progress) {
+        if (progress->isCancelled()) return result;
+        progress->setProgress(0.7f);
+    }
+
+    // Classify the runs of equal keys in chunks that start on a run boundary;
+    // each chunk collects its edges per class, still in key order
+    const float cosFeatureAngle = std::cos(glm::radians(featureAngleDegrees));
+    size_t chunks = 1;
+#ifdef HAVE_OPENMP
+    if (count > 100000) chunks = static_cast<size_t>(omp_get_max_threads());
+#endif
+    std::vector<size_t> bounds(chunks + 1);
+    for (size_t c = 0; c <= chunks; ++c) {
+        size_t b = std::max(count * c / chunks, c > 0 ? bounds[c - 1] : 0);
+        while (b > 0 && b < count && entries[b].key == entries[b - 1].key) ++b;
+        bounds[c] = b;
+    }
+    std::vector<std::array<std::vector<unsigned int>, Mesh::EdgeClassCount>> chunkEdges(chunks);
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(static, 1) if (chunks > 1)
+#endif
+    for (long long c = 0; c < static_cast<long long>(chunks); ++c) {
+        std::array<std::vector<unsigned int>, Mesh::EdgeClassCount>& edges = chunkEdges[c];
+        const size_t last = bounds[c + 1];
+        for (size_t i = bounds[c]; i < last;) {
+            size_t end = i + 1;
+            while (end < last && entries[end].key == entries[i].key) ++end;
+            Mesh::EdgeClass edgeClass;
+            if (end - i == 1) {
+                edgeClass = Mesh::BoundaryEdge;
+            } else if (end - i > 2) {
+                edgeClass = Mesh::NonManifoldEdge;
+            } else {
+                // Facets with opposite winding come out as feature edges too
+                const float cosAngle = glm::dot(normals[entries[i].facet], normals[entries[i + 1].facet]);
+                edgeClass = cosAngle < cosFeatureAngle ? Mesh::FeatureEdge : Mesh::SmoothEdge;
+            }
+            // Drawn with the lowest-indexed facet's vertices
+            edges[edgeClass].push_back(entries[i].from);
+            edges[edgeClass].push_back(entries[i].to);
+            i = end;
+        }
+    }
+
+    if (progress) progress->setProgress(0.9f);
+
+    // Concatenate class by class, chunks in order
+    size_t total = 0;
+    for (int edgeClass = 0; edgeClass < Mesh::EdgeClassCount; ++edgeClass) {
+        mesh.edgeClassOffsets[edgeClass] = static_cast<unsigned int>(total / 2);
+        for (const auto& edges : chunkEdges) {
+            total += edges[edgeClass].size();
+        }
+    }
+    mesh.edgeClassOffsets[Mesh::EdgeClassCount] = static_cast<unsigned int>(total / 2);
+    mesh.edgeIndices.reserve(total);
+    for (int edgeClass = 0; edgeClass < Mesh::EdgeClassCount; ++edgeClass) {
+        for (const auto& edges : chunkEdges) {
+            mesh.edgeIndices.insert(mesh.edgeIndices.end(), edges[edgeClass].begin(), edges[edgeClass].end());
+        }
+    }
+    result.edges = total / 2;
+
+    if (progress) {
+        progress->setMessage("Edges complete");
+        progress->setProgress(1.0f);
+    }
+    return result;
+}
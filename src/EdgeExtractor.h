@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Mesh.h"
+#include <cstddef>
+
+// Forward declaration - can be Progress_abstract (global) or gui::Progress_abstract
+class Progress_abstract;
+
+// Builds Mesh::edgeIndices: every facet perimeter edge once, however many facets
+// share it, classified by the facets around it:
+//   boundary      1 facet
+//   non-manifold  3 or more facets
+//   feature       2 facets whose normals differ by more than the feature angle
+//   smooth        2 facets, nearly coplanar
+// Edges are matched by their end positions, not vertex indices, so unwelded STL
+// triangles still find their neighbours.
+class EdgeExtractor {
+public:
+    struct Result {
+        size_t edges = 0;       // unique edges
+        size_t facetEdges = 0;  // perimeter edges before deduplication
+    };
+
+    static constexpr float kDefaultFeatureAngle = 30.0f; // degrees
+
+    // Replace mesh.edgeIndices / edgeClassOffsets. Deterministic for any thread count.
+    static Result extract(Mesh& mesh, float featureAngleDegrees = kDefaultFeatureAngle,
+                          Progress_abstract* progress = nullptr);
+};
@@ -0,0 +1,98 @@
+#include "GeometryLoader.h"
+#include "STLLoader.h"
+#include "XMLLoader.h"
+#include "MeshWelder.h"
+#include "MeshTriangulator.h"
+#include "EdgeExtractor.h"
+#include "MeshCache.h"
+#include "progress/Progress_abstract.h"  // Include for mySTLviewer standalone compilation
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+std::unique_ptr<Mesh> GeometryLoader::load(const std::string& path, const GeometryLoadOptions& options,
+                                           Progress_abstract* progress) {
+    // Everything that changes the resulting mesh is part of the cache key
+    std::ostringstream key;
+    key.precision(9);
+    key << "feature=" << options.featureAngle;
+    if (options.weldEpsilon >= 0.0f) {
+        key << ";weld=" << options.weldEpsilon;
+    }
+    const std::string cacheOptions = key.str();
+
+    if (options.useMeshCache) {
+        auto start = std::chrono::steady_clock::now();
+        std::unique_ptr<Mesh> mesh = MeshCache::load(path, cacheOptions, progress);
+        if (mesh) {
+            auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+            std::cout << "Loaded " << path << " from mesh cache in " << elapsed.count() << " ms" << std::endl;
+            return mesh;
+        }
+    }
+
+    std::unique_ptr<Mesh> mesh = loadFile(path, progress);
+    if (!mesh || (progress && progress->isCancelled())) {
+        return nullptr;
+    }
+
+    if (options.weldEpsilon >= 0.0f) {
+        size_t before = mesh->vertices.size();
+        MeshWelder::Result welded = MeshWelder::weld(*mesh, options.weldEpsilon, progress);
+        std::cout << "Welding removed " << welded.verticesRemoved << " of " << before << " vertices";
+        if (welded.facetsRemoved > 0) {
+            std::cout << " and " << welded.facetsRemoved << " collapsed facets";
+        }
+        std::cout << std::endl;
+        if (progress && progress->isCancelled()) {
+            return nullptr;
+        }
+    }
+
+    MeshTriangulator::triangulate(*mesh);
+    if (progress && progress->isCancelled()) {
+        return nullptr;
+    }
+
+    EdgeExtractor::Result edges = EdgeExtractor::extract(*mesh, options.featureAngle, progress);
+    if (progress && progress->isCancelled()) {
+        return nullptr;
+    }
+    std::cout << "Edges: " << edges.edges << " unique of " << edges.facetEdges << " facet edges ("
+              << mesh->edgeCount(Mesh::BoundaryEdge) << " boundary, "
+              << mesh->edgeCount(Mesh::NonManifoldEdge) << " non-manifold, "
+              << mesh->edgeCount(Mesh::FeatureEdge) << " feature)" << std::endl;
+
+    if (options.useMeshCache) {
+        MeshCache::store(path, cacheOptions, *mesh);
+    }
+    return mesh;
+}
+
+std::unique_ptr<Mesh> GeometryLoader::loadFile(const std::string& path, Progress_abstract* progress) {
+    std::unique_ptr<Mesh> mesh;
+
+    // Determine file type and load accordingly
+    try {
+        size_t dotPos = path.find_last_of('.');
+        if (dotPos != std::string::npos) {
+            std::string ext = path.substr(dotPos);
+            if (ext == ".xml" || ext == ".XML") {
+                mesh = XMLLoader::load(path, progress);
+            } else if (ext == ".zip" || ext == ".ZIP") {
+                // Zip files should contain XML, use XMLLoader
+                mesh = XMLLoader::load(path, progress);
+            } else {
+                mesh = STLLoader::load(path, progress);
+            }
+        } else {
+            // No extension, try STL
+            mesh = STLLoader::load(path, progress);
+        }
+    } catch (...) {
+        // Handle any exceptions during loading
+        mesh = nullptr;
+    }
+
+    return mesh;
+}
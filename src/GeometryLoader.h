@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Mesh.h"
+#include "EdgeExtractor.h"
+#include <memory>
+#include <string>
+
+// Forward declaration - can be Progress_abstract (global) or gui::Progress_abstract
+class Progress_abstract;
+
+struct GeometryLoadOptions {
+    float weldEpsilon = -1.0f; // vertex welding distance; negative = welding off
+    bool useMeshCache = true;  // read and refresh the on-disk mesh cache
+    float featureAngle = EdgeExtractor::kDefaultFeatureAngle; // degrees between facet normals that make a shared edge a feature edge
+};
+
+// Loads any supported geometry file into a render-ready mesh: picks the loader
+// from the extension (STL, MolFlow XML, zipped XML), welds if requested,
+// triangulates and extracts the edges, going through MeshCache when enabled. Safe to call from a
+// worker thread.
+class GeometryLoader {
+public:
+    // Returns nullptr if the file could not be loaded or progress was cancelled
+    static std::unique_ptr<Mesh> load(const std::string& path, const GeometryLoadOptions& options,
+                                      Progress_abstract* progress = nullptr);
+
+private:
+    static std::unique_ptr<Mesh> loadFile(const std::string& path, Progress_abstract* progress);
+};
@@ -0,0 +1,57 @@
+#include "MappedFile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define STLVIEWER_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+#ifdef STLVIEWER_HAVE_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(st.st_size);
+    void* ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (ptr == MAP_FAILED) {
+        return false;
+    }
+
+    // Loaders walk the file front to back; let the kernel read ahead aggressively
+    madvise(ptr, size, MADV_SEQUENTIAL);
+
+    m_data = static_cast<const char*>(ptr);
+    m_size = size;
+    return true;
+#else
+    (void)filename;
+    return false;
+#endif
+}
+
+void MappedFile::close() {
+#ifdef STLVIEWER_HAVE_MMAP
+    if (m_data) {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
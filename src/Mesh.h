@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <array>
 #include <vector>
 
 struct Vertex {
@@ -14,37 +15,146 @@ struct Triangle {
 };
 
 // A facet represents a polygon (e.g., triangle, quad, etc.)
-// with a list of vertex indices that form the polygon
-struct Facet {
-    std::vector<unsigned int> indices;
+// FacetView is a non-owning view of the vertex indices that form one polygon
+class FacetView {
+public:
+    FacetView(const unsigned int* indices, size_t count) : m_indices(indices), m_count(count) {}
     
-    // Constructor for convenience
-    Facet() = default;
-    Facet(std::initializer_list<unsigned int> idxList) : indices(idxList) {}
+    const unsigned int* begin() const { return m_indices; }
+    const unsigned int* end() const { return m_indices + m_count; }
+    unsigned int operator[](size_t i) const { return m_indices[i]; }
+    size_t size() const { return m_count; }
     
     // Helper to get number of vertices in this polygon
-    size_t vertexCount() const { return indices.size(); }
+    size_t vertexCount() const { return m_count; }
     
     // Check if this is a triangle
-    bool isTriangle() const { return indices.size() == 3; }
+    bool isTriangle() const { return m_count == 3; }
+    
+private:
+    const unsigned int* m_indices;
+    size_t m_count;
+};
+
+// All facets of a mesh in compressed sparse row form: one flat index array plus
+// an offsets array, so facet i uses indices[offsets[i]] .. indices[offsets[i + 1] - 1].
+// Avoids one heap allocation per facet and keeps index data contiguous.
+class FacetList {
+public:
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> offsets{0}; // size() + 1 entries, offsets[0] == 0
+    
+    class const_iterator {
+    public:
+        const_iterator(const FacetList* list, size_t i) : m_list(list), m_i(i) {}
+        FacetView operator*() const { return (*m_list)[m_i]; }
+        const_iterator& operator++() { ++m_i; return *this; }
+        bool operator==(const const_iterator& o) const { return m_i == o.m_i; }
+        bool operator!=(const const_iterator& o) const { return m_i != o.m_i; }
+    private:
+        const FacetList* m_list;
+        size_t m_i;
+    };
+    
+    size_t size() const { return offsets.size() - 1; }
+    bool empty() const { return offsets.size() <= 1; }
+    FacetView operator[](size_t i) const {
+        return FacetView(indices.data() + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+    FacetView back() const { return (*this)[size() - 1]; }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+    
+    void clear() {
+        indices.clear();
+        offsets.assign(1, 0);
+    }
+    
+    void reserve(size_t facetCount, size_t indexCount) {
+        offsets.reserve(facetCount + 1);
+        indices.reserve(indexCount);
+    }
+    
+    // Append a facet from a list of vertex indices
+    void add(std::initializer_list<unsigned int> idxList) {
+        indices.insert(indices.end(), idxList.begin(), idxList.end());
+        closeFacet();
+    }
+    
+    // Incremental construction: push the facet's indices onto `indices`,
+    // then call closeFacet() to end it
+    void closeFacet() { offsets.push_back(static_cast<unsigned int>(indices.size())); }
+    
+    // Size the list for `count` triangles (facet t uses indices[3t .. 3t + 2]),
+    // leaving the index values for the caller to fill in
+    void resizeTriangles(size_t count) {
+        indices.resize(count * 3);
+        offsets.resize(count + 1);
+        for (size_t i = 0; i <= count; ++i) {
+            offsets[i] = static_cast<unsigned int>(i * 3);
+        }
+    }
 };
 
 struct Mesh {
     std::vector<Vertex> vertices;
-    std::vector<Facet> facets;
+    FacetList facets;
     glm::vec3 min_bounds;
     glm::vec3 max_bounds;
     
+    // Render topology derived from the facets by MeshTriangulator and
+    // EdgeExtractor (empty until built, and cleared whenever the facets change)
+    std::vector<unsigned int> triangleIndices; // 3 vertex indices per triangle
+    std::vector<unsigned int> triangleFacets;  // source facet of each triangle
+    
+    // Unique facet edges (see EdgeExtractor), grouped by class in the order of
+    // EdgeClass. Edges of class c are edgeIndices[2 * edgeClassOffsets[c] ..
+    // 2 * edgeClassOffsets[c + 1]); all edges but the smooth ones form a prefix.
+    enum EdgeClass { BoundaryEdge, NonManifoldEdge, FeatureEdge, SmoothEdge, EdgeClassCount };
+    std::vector<unsigned int> edgeIndices;     // 2 vertex indices per edge
+    std::array<unsigned int, EdgeClassCount + 1> edgeClassOffsets{};
+    
+    size_t edgeCount(EdgeClass c) const { return edgeClassOffsets[c + 1] - edgeClassOffsets[c]; }
+    
+    void clearTriangulation() {
+        triangleIndices.clear();
+        triangleFacets.clear();
+        edgeIndices.clear();
+        edgeClassOffsets.fill(0);
+    }
+    
     void calculateBounds() {
         if (vertices.empty()) return;
         
-        min_bounds = vertices[0].position;
-        max_bounds = vertices[0].position;
+        const glm::vec3 first = vertices[0].position;
+        min_bounds = first;
+        max_bounds = first;
         
+#ifdef HAVE_OPENMP
+        // Per-thread partial bounds merged at the end; min/max is order-independent.
+        // The partials start from a copy: with nowait, other threads may already
+        // be merging into min_bounds/max_bounds
+        #pragma omp parallel if (vertices.size() > 100000)
+        {
+            glm::vec3 localMin = first;
+            glm::vec3 localMax = first;
+            #pragma omp for nowait
+            for (long long i = 0; i < static_cast<long long>(vertices.size()); ++i) {
+                localMin = glm::min(localMin, vertices[i].position);
+                localMax = glm::max(localMax, vertices[i].position);
+            }
+            #pragma omp critical
+            {
+                min_bounds = glm::min(min_bounds, localMin);
+                max_bounds = glm::max(max_bounds, localMax);
+            }
+        }
+#else
         for (const auto& v : vertices) {
             min_bounds = glm::min(min_bounds, v.position);
             max_bounds = glm::max(max_bounds, v.position);
         }
+#endif
     }
     
     glm::vec3 getCenter() const {
@@ -0,0 +1,171 @@
+#include "MeshBVH.h"
+#include "progress/Progress_abstract.h"  // Include for mySTLviewer standalone compilation
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+// Distance along the ray to where it enters the box, or infinity if it misses
+// the box or the box lies entirely before tMax
+inline float slabEntry(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin,
+                       const glm::vec3& inverseDirection, float tMax) {
+    const glm::vec3 t0 = (min - origin) * inverseDirection;
+    const glm::vec3 t1 = (max - origin) * inverseDirection;
+    const glm::vec3 tNear = glm::min(t0, t1);
+    const glm::vec3 tFar = glm::max(t0, t1);
+    const float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+    const float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+    return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+}
+
+// Möller–Trumbore, both faces
+inline bool intersectTriangle(const glm::vec3& origin, const glm::vec3& direction,
+                              const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float& t) {
+    const glm::vec3 ab = b - a;
+    const glm::vec3 ac = c - a;
+    const glm::vec3 p = glm::cross(direction, ac);
+    const float det = glm::dot(ab, p);
+    if (std::abs(det) < 1e-20f) return false;
+    const float inverseDet = 1.0f / det;
+    const glm::vec3 s = origin - a;
+    const float u = glm::dot(s, p) * inverseDet;
+    if (u < 0.0f || u > 1.0f) return false;
+    const glm::vec3 q = glm::cross(s, ab);
+    const float v = glm::dot(direction, q) * inverseDet;
+    if (v < 0.0f || u + v > 1.0f) return false;
+    t = glm::dot(ac, q) * inverseDet;
+    return t >= 0.0f;
+}
+
+} // namespace
+
+bool MeshBVH::build(const Mesh& mesh, Progress_abstract* progress) {
+    m_nodes.clear();
+    const size_t triangleCount = mesh.triangleIndices.size() / 3;
+    if (triangleCount == 0) {
+        return true;
+    }
+
+    if (progress) {
+        progress->setMessage("Building picking hierarchy...");
+    }
+
+    // Leaf bounds
+    const size_t leafCount = (triangleCount + kLeafTriangles - 1) / kLeafTriangles;
+    std::vector<Node> leaves(leafCount);
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(static) if (leafCount > 10000)
+#endif
+    for (long long l = 0; l < static_cast<long long>(leafCount); ++l) {
+        Node& leaf = leaves[l];
+        leaf.first = static_cast<unsigned int>(l * kLeafTriangles);
+        leaf.count = static_cast<unsigned int>(std::min<size_t>(kLeafTriangles, triangleCount - leaf.first));
+        leaf.min = glm::vec3(std::numeric_limits<float>::max());
+        leaf.max = glm::vec3(-std::numeric_limits<float>::max());
+        const unsigned int* index = mesh.triangleIndices.data() + 3 * size_t(leaf.first);
+        for (size_t i = 0; i < size_t(leaf.count) * 3; ++i) {
+            const glm::vec3& p = mesh.vertices[index[i]].position;
+            leaf.min = glm::min(leaf.min, p);
+            leaf.max = glm::max(leaf.max, p);
+        }
+    }
+
+    if (progress) {
+        if (progress->isCancelled()) return false;
+    }
+
+    // Same layout as MeshClusters: balanced binary tree over the leaves in
+    // triangle order, siblings adjacent, inner bounds filled bottom-up
+    m_nodes.reserve(2 * leafCount - 1);
+    m_nodes.push_back(Node());
+    struct Pending { size_t node; size_t firstLeaf; size_t count; };
+    std::vector<Pending> pending{{0, 0, leafCount}};
+    std::vector<size_t> innerNodes;
+    while (!pending.empty()) {
+        const Pending p = pending.back();
+        pending.pop_back();
+        if (p.count == 1) {
+            m_nodes[p.node] = leaves[p.firstLeaf];
+            continue;
+        }
+        const size_t firstChild = m_nodes.size();
+        m_nodes.resize(firstChild + 2);
+        m_nodes[p.node].first = static_cast<unsigned int>(firstChild);
+        m_nodes[p.node].count = 0;
+        const size_t half = p.count / 2;
+        pending.push_back({firstChild, p.firstLeaf, half});
+        pending.push_back({firstChild + 1, p.firstLeaf + half, p.count - half});
+        innerNodes.push_back(p.node);
+    }
+    for (auto it = innerNodes.rbegin(); it != innerNodes.rend(); ++it) {
+        Node& node = m_nodes[*it];
+        const Node& a = m_nodes[node.first];
+        const Node& b = m_nodes[node.first + 1];
+        node.min = glm::min(a.min, b.min);
+        node.max = glm::max(a.max, b.max);
+    }
+    return true;
+}
+
+bool MeshBVH::raycast(const Mesh& mesh, const glm::vec3& origin, const glm::vec3& direction, Hit& hit) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    // Huge rather than infinite reciprocals for axis-parallel rays, so the slab
+    // test never computes 0 * inf
+    glm::vec3 inverseDirection;
+    for (int a = 0; a < 3; ++a) {
+        inverseDirection[a] = std::abs(direction[a]) > 1e-30f ? 1.0f / direction[a]
+                                                               : std::copysign(1e30f, direction[a]);
+    }
+
+    float nearest = std::numeric_limits<float>::max();
+    bool found = false;
+    if (slabEntry(m_nodes[0].min, m_nodes[0].max, origin, inverseDirection, nearest) ==
+        std::numeric_limits<float>::infinity()) {
+        return false;
+    }
+
+    // Nearer child first, so the far one is usually pruned by the closest hit so far
+    struct Entry { unsigned int node; float t; };
+    Entry stack[64];
+    int top = 0;
+    stack[top++] = {0, 0.0f};
+    while (top > 0) {
+        const Entry entry = stack[--top];
+        if (entry.t > nearest) continue;
+        const Node& node = m_nodes[entry.node];
+        if (node.count > 0) {
+            const unsigned int* index = mesh.triangleIndices.data() + 3 * size_t(node.first);
+            for (unsigned int i = 0; i < node.count; ++i, index += 3) {
+                float t;
+                if (intersectTriangle(origin, direction, mesh.vertices[index[0]].position,
+                                      mesh.vertices[index[1]].position, mesh.vertices[index[2]].position, t) &&
+                    t < nearest) {
+                    nearest = t;
+                    hit.triangle = node.first + i;
+                    hit.t = t;
+                    found = true;
+                }
+            }
+            continue;
+        }
+        const Node& a = m_nodes[node.first];
+        const Node& b = m_nodes[node.first + 1];
+        float ta = slabEntry(a.min, a.max, origin, inverseDirection, nearest);
+        float tb = slabEntry(b.min, b.max, origin, inverseDirection, nearest);
+        unsigned int nearChild = node.first, farChild = node.first + 1;
+        if (tb < ta) {
+            std::swap(ta, tb);
+            std::swap(nearChild, farChild);
+        }
+        if (tb != std::numeric_limits<float>::infinity()) stack[top++] = {farChild, tb};
+        if (ta != std::numeric_limits<float>::infinity()) stack[top++] = {nearChild, ta};
+    }
+    return found;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Mesh.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+// Forward declaration - can be Progress_abstract (global) or gui::Progress_abstract
+class Progress_abstract;
+
+// Bounding volume hierarchy over a mesh's triangles for ray casts (picking).
+// The triangles must already be in a spatially coherent order, as
+// MeshClusters::build leaves them: nodes split their triangle range in half,
+// so every node covers a contiguous range and no index permutation is stored.
+class MeshBVH {
+public:
+    static constexpr unsigned int kLeafTriangles = 16;
+
+    struct Hit {
+        unsigned int triangle = 0; // index into mesh.triangleFacets
+        float t = 0.0f;            // origin + t * direction is the hit point
+    };
+
+    // Replace the hierarchy with one over mesh.triangleIndices. Returns false if cancelled.
+    bool build(const Mesh& mesh, Progress_abstract* progress = nullptr);
+
+    // First triangle hit by the ray origin + t * direction, t >= 0, front or
+    // back face. `mesh` must be the one build() saw.
+    bool raycast(const Mesh& mesh, const glm::vec3& origin, const glm::vec3& direction, Hit& hit) const;
+
+    bool empty() const { return m_nodes.empty(); }
+    size_t memoryBytes() const { return m_nodes.size() * sizeof(Node); }
+
+private:
+    // 32 bytes. Leaves: triangles [first, first + count). Inner nodes: count == 0
+    // and the children are nodes[first] and nodes[first + 1].
+    struct Node {
+        glm::vec3 min;
+        unsigned int first;
+        glm::vec3 max;
+        unsigned int count;
+    };
+
+    std::vector<Node> m_nodes; // m_nodes[0] is the root
+};
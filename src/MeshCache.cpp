@@ -0,0 +1,385 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "progress/Progress_abstract.h"  // Include for mySTLviewer standalone compilation
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Bump whenever the layout or the meaning of any stored array changes
+constexpr uint32_t kCacheVersion = 2;
+constexpr char kCacheMagic[8] = {'S', 'T', 'L', 'V', 'M', 'E', 'S', 'H'};
+// Written in native order; a file from a machine with the other byte order is ignored
+constexpr uint32_t kByteOrderMark = 0x01020304u;
+constexpr size_t kSectionAlignment = 16;
+// Sections are hashed in blocks of this size (in parallel), then the block hashes are folded in order
+constexpr size_t kHashBlockBytes = size_t(1) << 20;
+
+constexpr uint64_t kFnvOffsetBasis = 0xCBF29CE484222325ULL;
+constexpr uint64_t kFnvPrime = 0x100000001B3ULL;
+
+static_assert(std::is_trivially_copyable<Vertex>::value && sizeof(Vertex) == 24,
+              "the cache stores Vertex arrays as raw bytes");
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t keyBytes;          // source path + '\0' + load options, stored right after the header
+    uint64_t vertexCount;
+    uint64_t facetCount;
+    uint64_t facetIndexCount;
+    uint64_t triangleCount;
+    uint64_t edgeIndexCount;
+    float minBounds[3];
+    float maxBounds[3];
+    uint32_t edgeClassOffsets[Mesh::EdgeClassCount + 1]; // see Mesh::edgeClassOffsets
+    uint64_t contentHash;       // hash of the key and every array
+};
+
+struct Section {
+    const char* data;
+    size_t bytes;
+};
+
+size_t alignUp(size_t value) {
+    return (value + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+}
+
+inline uint64_t mix64(uint64_t h) {
+    // splitmix64 finalizer
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h;
+}
+
+uint64_t fnv1a(const char* data, size_t size) {
+    uint64_t h = kFnvOffsetBasis;
+    for (size_t i = 0; i < size; ++i) {
+        h = (h ^ static_cast<unsigned char>(data[i])) * kFnvPrime;
+    }
+    return h;
+}
+
+// FNV-1a over 8-byte words in four independent lanes, so it runs close to memory speed
+uint64_t hashBlock(const char* data, size_t size) {
+    uint64_t lanes[4] = {kFnvOffsetBasis, kFnvOffsetBasis ^ 1, kFnvOffsetBasis ^ 2, kFnvOffsetBasis ^ 3};
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int l = 0; l < 4; ++l) {
+            uint64_t word;
+            std::memcpy(&word, data + i + l * 8, 8);
+            lanes[l] = (lanes[l] ^ word) * kFnvPrime;
+            lanes[l] ^= lanes[l] >> 29;
+        }
+    }
+    uint64_t h = fnv1a(data + i, size - i) ^ size;
+    for (uint64_t lane : lanes) {
+        h = mix64(h ^ lane);
+    }
+    return h;
+}
+
+uint64_t hashSections(const std::vector<Section>& sections) {
+    std::vector<Section> blocks;
+    for (const Section& section : sections) {
+        for (size_t offset = 0; offset < section.bytes; offset += kHashBlockBytes) {
+            blocks.push_back({section.data + offset, std::min(kHashBlockBytes, section.bytes - offset)});
+        }
+    }
+    std::vector<uint64_t> blockHashes(blocks.size());
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) if (blocks.size() > 1)
+#endif
+    for (long long b = 0; b < static_cast<long long>(blocks.size()); ++b) {
+        blockHashes[b] = hashBlock(blocks[b].data, blocks[b].bytes);
+    }
+
+    uint64_t h = kFnvOffsetBasis;
+    for (const Section& section : sections) {
+        h = mix64(h ^ section.bytes);
+    }
+    for (uint64_t blockHash : blockHashes) {
+        h = mix64(h ^ blockHash);
+    }
+    return h;
+}
+
+// Identity of the source file: size and modification time
+bool sourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& time) {
+    std::error_code ec;
+    size = static_cast<uint64_t>(fs::file_size(sourcePath, ec));
+    if (ec) {
+        return false;
+    }
+    const auto writeTime = fs::last_write_time(sourcePath, ec);
+    if (ec) {
+        return false;
+    }
+    time = static_cast<int64_t>(writeTime.time_since_epoch().count());
+    return true;
+}
+
+std::string absoluteSourcePath(const std::string& sourcePath) {
+    std::error_code ec;
+    fs::path path = fs::weakly_canonical(fs::absolute(sourcePath, ec), ec);
+    return ec ? sourcePath : path.string();
+}
+
+std::string cacheKey(const std::string& sourcePath, const std::string& options) {
+    std::string key = absoluteSourcePath(sourcePath);
+    key.push_back('\0');
+    key += options;
+    return key;
+}
+
+fs::path cacheDirectory() {
+    const char* overrideDir = std::getenv("MYSTLVIEWER_CACHE_DIR");
+    if (overrideDir && *overrideDir) {
+        return fs::path(overrideDir);
+    }
+#if defined(_WIN32)
+    const char* localAppData = std::getenv("LOCALAPPDATA");
+    if (localAppData && *localAppData) {
+        return fs::path(localAppData) / "mySTLViewer" / "cache";
+    }
+#elif defined(__APPLE__)
+    const char* home = std::getenv("HOME");
+    if (home && *home) {
+        return fs::path(home) / "Library" / "Caches" / "mySTLViewer";
+    }
+#else
+    const char* xdgCache = std::getenv("XDG_CACHE_HOME");
+    if (xdgCache && *xdgCache) {
+        return fs::path(xdgCache) / "mySTLViewer";
+    }
+    const char* home = std::getenv("HOME");
+    if (home && *home) {
+        return fs::path(home) / ".cache" / "mySTLViewer";
+    }
+#endif
+    std::error_code ec;
+    return fs::temp_directory_path(ec) / "mySTLViewer-cache";
+}
+
+// Array sections in file order, sized from the header counts
+std::vector<Section> arraySections(const CacheHeader& header) {
+    return {
+        {nullptr, header.vertexCount * sizeof(Vertex)},
+        {nullptr, (header.facetCount + 1) * sizeof(unsigned int)},
+        {nullptr, header.facetIndexCount * sizeof(unsigned int)},
+        {nullptr, header.triangleCount * 3 * sizeof(unsigned int)},
+        {nullptr, header.triangleCount * sizeof(unsigned int)},
+        {nullptr, header.edgeIndexCount * sizeof(unsigned int)},
+    };
+}
+
+template <typename T>
+void copySection(const Section& section, std::vector<T>& out) {
+    out.resize(section.bytes / sizeof(T));
+    if (section.bytes > 0) {
+        std::memcpy(out.data(), section.data, section.bytes);
+    }
+}
+
+} // namespace
+
+std::string MeshCache::cacheFilePath(const std::string& sourcePath) {
+    const std::string absolutePath = absoluteSourcePath(sourcePath);
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << fnv1a(absolutePath.data(), absolutePath.size())
+         << ".meshcache";
+    return (cacheDirectory() / name.str()).string();
+}
+
+std::unique_ptr<Mesh> MeshCache::load(const std::string& sourcePath, const std::string& options,
+                                      Progress_abstract* progress) {
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (!sourceStamp(sourcePath, sourceSize, sourceTime)) {
+        return nullptr;
+    }
+
+    const std::string path = cacheFilePath(sourcePath);
+    MappedFile file;
+    if (!file.open(path) || file.size() < sizeof(CacheHeader)) {
+        return nullptr; // No entry yet
+    }
+
+    // Stale entries (other version, edited source, other options) are silently rebuilt
+    CacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+        header.version != kCacheVersion || header.byteOrder != kByteOrderMark ||
+        header.sourceSize != sourceSize || header.sourceTime != sourceTime) {
+        return nullptr;
+    }
+    const std::string key = cacheKey(sourcePath, options);
+    if (header.keyBytes != key.size()) {
+        return nullptr;
+    }
+
+    // Every count must fit in the file before any size arithmetic is trusted
+    const uint64_t limit = file.size();
+    if (header.vertexCount > limit || header.facetCount > limit || header.facetIndexCount > limit ||
+        header.triangleCount > limit || header.edgeIndexCount > limit) {
+        std::cerr << "Ignoring corrupt mesh cache: " << path << std::endl;
+        return nullptr;
+    }
+    std::vector<Section> sections = arraySections(header);
+    sections.insert(sections.begin(), Section{nullptr, key.size()});
+    size_t offset = alignUp(sizeof(CacheHeader));
+    for (Section& section : sections) {
+        section.data = file.data() + offset;
+        offset += alignUp(section.bytes);
+    }
+    if (offset != file.size() || std::memcmp(sections[0].data, key.data(), key.size()) != 0) {
+        if (offset != file.size()) {
+            std::cerr << "Ignoring corrupt mesh cache: " << path << std::endl;
+        }
+        return nullptr;
+    }
+
+    if (progress) {
+        progress->setMessage("Loading cached mesh...");
+        progress->setProgress(0.2f);
+    }
+
+    if (hashSections(sections) != header.contentHash) {
+        std::cerr << "Ignoring corrupt mesh cache: " << path << std::endl;
+        return nullptr;
+    }
+
+    if (progress) {
+        progress->setProgress(0.6f);
+    }
+
+    auto mesh = std::make_unique<Mesh>();
+    copySection(sections[1], mesh->vertices);
+    copySection(sections[2], mesh->facets.offsets);
+    copySection(sections[3], mesh->facets.indices);
+    copySection(sections[4], mesh->triangleIndices);
+    copySection(sections[5], mesh->triangleFacets);
+    copySection(sections[6], mesh->edgeIndices);
+    mesh->min_bounds = glm::vec3(header.minBounds[0], header.minBounds[1], header.minBounds[2]);
+    mesh->max_bounds = glm::vec3(header.maxBounds[0], header.maxBounds[1], header.maxBounds[2]);
+    bool edgeClassesValid = header.edgeClassOffsets[0] == 0 &&
+                            uint64_t(header.edgeClassOffsets[Mesh::EdgeClassCount]) * 2 == header.edgeIndexCount;
+    for (int c = 0; c <= Mesh::EdgeClassCount; ++c) {
+        mesh->edgeClassOffsets[c] = header.edgeClassOffsets[c];
+        if (c > 0 && header.edgeClassOffsets[c] < header.edgeClassOffsets[c - 1]) edgeClassesValid = false;
+    }
+
+    if (mesh->facets.offsets.front() != 0 || mesh->facets.offsets.back() != header.facetIndexCount ||
+        !edgeClassesValid) {
+        std::cerr << "Ignoring corrupt mesh cache: " << path << std::endl;
+        return nullptr;
+    }
+
+    if (progress) {
+        progress->setMessage("Complete");
+        progress->setProgress(1.0f);
+    }
+
+    return mesh;
+}
+
+bool MeshCache::store(const std::string& sourcePath, const std::string& options, const Mesh& mesh) {
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (!sourceStamp(sourcePath, sourceSize, sourceTime)) {
+        return false;
+    }
+
+    const fs::path path = cacheFilePath(sourcePath);
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    if (ec) {
+        std::cerr << "Failed to create mesh cache directory " << path.parent_path() << ": " << ec.message() << std::endl;
+        return false;
+    }
+
+    const std::string key = cacheKey(sourcePath, options);
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+    header.version = kCacheVersion;
+    header.byteOrder = kByteOrderMark;
+    header.sourceSize = sourceSize;
+    header.sourceTime = sourceTime;
+    header.keyBytes = key.size();
+    header.vertexCount = mesh.vertices.size();
+    header.facetCount = mesh.facets.size();
+    header.facetIndexCount = mesh.facets.indices.size();
+    header.triangleCount = mesh.triangleFacets.size();
+    header.edgeIndexCount = mesh.edgeIndices.size();
+    for (int i = 0; i < 3; ++i) {
+        header.minBounds[i] = mesh.min_bounds[i];
+        header.maxBounds[i] = mesh.max_bounds[i];
+    }
+    for (int c = 0; c <= Mesh::EdgeClassCount; ++c) {
+        header.edgeClassOffsets[c] = mesh.edgeClassOffsets[c];
+    }
+
+    const std::vector<Section> sections = {
+        {key.data(), key.size()},
+        {reinterpret_cast<const char*>(mesh.vertices.data()), mesh.vertices.size() * sizeof(Vertex)},
+        {reinterpret_cast<const char*>(mesh.facets.offsets.data()), mesh.facets.offsets.size() * sizeof(unsigned int)},
+        {reinterpret_cast<const char*>(mesh.facets.indices.data()), mesh.facets.indices.size() * sizeof(unsigned int)},
+        {reinterpret_cast<const char*>(mesh.triangleIndices.data()), mesh.triangleIndices.size() * sizeof(unsigned int)},
+        {reinterpret_cast<const char*>(mesh.triangleFacets.data()), mesh.triangleFacets.size() * sizeof(unsigned int)},
+        {reinterpret_cast<const char*>(mesh.edgeIndices.data()), mesh.edgeIndices.size() * sizeof(unsigned int)},
+    };
+    if (mesh.triangleIndices.size() != mesh.triangleFacets.size() * 3) {
+        std::cerr << "Mesh cache: triangle arrays are inconsistent, not caching" << std::endl;
+        return false;
+    }
+    header.contentHash = hashSections(sections);
+
+    // Write under a temporary name and rename, so a reader never maps a partial file
+    fs::path tempPath = path;
+    tempPath += ".tmp" + std::to_string(std::random_device{}());
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        const char padding[kSectionAlignment] = {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(padding, alignUp(sizeof(header)) - sizeof(header));
+        for (const Section& section : sections) {
+            out.write(section.data, section.bytes);
+            out.write(padding, alignUp(section.bytes) - section.bytes);
+        }
+        out.close();
+        if (!out) {
+            std::cerr << "Failed to write mesh cache " << tempPath << std::endl;
+            fs::remove(tempPath, ec);
+            return false;
+        }
+    }
+    fs::rename(tempPath, path, ec);
+    if (ec) {
+        std::cerr << "Failed to write mesh cache " << path << ": " << ec.message() << std::endl;
+        fs::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Mesh.h"
+#include <memory>
+#include <string>
+
+// Forward declaration - can be Progress_abstract (global) or gui::Progress_abstract
+class Progress_abstract;
+
+// On-disk cache of loaded, triangulated meshes so that reopening a large
+// geometry skips parsing and triangulation.
+//
+// One file per source, named after a hash of its absolute path, in the user
+// cache directory (or $MYSTLVIEWER_CACHE_DIR). An entry is valid only for the
+// same path, load options, file size and modification time, and when the
+// stored content hash matches. The file is a fixed header followed by the raw
+// vertex and index arrays (16-byte aligned), and is read through a memory map.
+class MeshCache {
+public:
+    // Returns the cached mesh for `sourcePath` loaded with `options`, or nullptr
+    // if there is no valid entry
+    static std::unique_ptr<Mesh> load(const std::string& sourcePath, const std::string& options,
+                                      Progress_abstract* progress = nullptr);
+
+    // Write a cache entry for `mesh`, which must be triangulated and have its
+    // edges extracted (see MeshTriangulator, EdgeExtractor).
+    // Returns false if the entry could not be written.
+    static bool store(const std::string& sourcePath, const std::string& options, const Mesh& mesh);
+
+    // Cache file used for `sourcePath`
+    static std::string cacheFilePath(const std::string& sourcePath);
+};
@@ -0,0 +1,227 @@
+#include "MeshClusters.h"
+#include "ParallelSort.h"
+#include "progress/Progress_abstract.h"  // Include for mySTLviewer standalone compilation
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+struct MortonKey {
+    uint64_t code;
+    unsigned int triangle;
+};
+
+// Spread the low 21 bits of v so that there are two zero bits between each
+inline uint64_t spreadBits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffULL;
+    v = (v | v << 16) & 0x1f0000ff0000ffULL;
+    v = (v | v << 8) & 0x100f00f00f00f00fULL;
+    v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+    v = (v | v << 2) & 0x1249249249249249ULL;
+    return v;
+}
+
+// 63-bit Morton code of a point already scaled to [0, 1] per axis
+inline uint64_t mortonCode(const glm::vec3& unit) {
+    const float cells = static_cast<float>(1 << 21);
+    glm::vec3 cell = glm::clamp(unit * cells, glm::vec3(0.0f), glm::vec3(cells - 1.0f));
+    return spreadBits(static_cast<uint64_t>(cell.x)) |
+           spreadBits(static_cast<uint64_t>(cell.y)) << 1 |
+           spreadBits(static_cast<uint64_t>(cell.z)) << 2;
+}
+
+enum class Containment { Outside, Intersecting, Inside };
+
+} // namespace
+
+MeshClusters MeshClusters::build(Mesh& mesh, Progress_abstract* progress) {
+    MeshClusters clusters;
+    const size_t triangleCount = mesh.triangleFacets.size();
+    if (triangleCount == 0 || mesh.triangleIndices.size() != triangleCount * 3) {
+        return clusters;
+    }
+
+    if (progress) {
+        progress->setMessage("Clustering triangles...");
+    }
+
+    // Morton order of the centroids keeps each run of consecutive triangles compact in space
+    const glm::vec3 origin = mesh.min_bounds;
+    const glm::vec3 extent = mesh.max_bounds - mesh.min_bounds;
+    glm::vec3 toUnit(0.0f);
+    for (int a = 0; a < 3; ++a) {
+        if (extent[a] > 0.0f) toUnit[a] = 1.0f / extent[a];
+    }
+    std::vector<MortonKey> keys(triangleCount);
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(static) if (triangleCount > 100000)
+#endif
+    for (long long t = 0; t < static_cast<long long>(triangleCount); ++t) {
+        const unsigned int* tri = mesh.triangleIndices.data() + 3 * t;
+        glm::vec3 centroid = (mesh.vertices[tri[0]].position + mesh.vertices[tri[1]].position +
+                              mesh.vertices[tri[2]].position) / 3.0f;
+        keys[t] = {mortonCode((centroid - origin) * toUnit), static_cast<unsigned int>(t)};
+    }
+    // Ties broken by triangle index, so the order is the same for any thread count
+    parallelSort(keys, [](const MortonKey& a, const MortonKey& b) {
+        return a.code != b.code ? a.code < b.code : a.triangle < b.triangle;
+    });
+
+    std::vector<unsigned int> triangleIndices(triangleCount * 3);
+    std::vector<unsigned int> triangleFacets(triangleCount);
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(static) if (triangleCount > 100000)
+#endif
+    for (long long t = 0; t < static_cast<long long>(triangleCount); ++t) {
+        const unsigned int source = keys[t].triangle;
+        std::copy_n(mesh.triangleIndices.data() + 3 * size_t(source), 3, triangleIndices.data() + 3 * t);
+        triangleFacets[t] = mesh.triangleFacets[source];
+    }
+    std::vector<MortonKey>().swap(keys);
+    mesh.triangleIndices.swap(triangleIndices);
+    mesh.triangleFacets.swap(triangleFacets);
+
+    if (progress) {
+        if (progress->isCancelled()) return clusters;
+    }
+
+    // Leaf bounds
+    const size_t clusterCount = (triangleCount + kClusterTriangles - 1) / kClusterTriangles;
+    std::vector<Node> leaves(clusterCount);
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(static) if (clusterCount > 16)
+#endif
+    for (long long c = 0; c < static_cast<long long>(clusterCount); ++c) {
+        Node& leaf = leaves[c];
+        leaf.firstTriangle = static_cast<unsigned int>(c * kClusterTriangles);
+        leaf.triangleCount = static_cast<unsigned int>(
+            std::min<size_t>(kClusterTriangles, triangleCount - leaf.firstTriangle));
+        leaf.firstChild = 0;
+        leaf.min = glm::vec3(std::numeric_limits<float>::max());
+        leaf.max = glm::vec3(-std::numeric_limits<float>::max());
+        const unsigned int* index = mesh.triangleIndices.data() + 3 * size_t(leaf.firstTriangle);
+        for (size_t i = 0; i < size_t(leaf.triangleCount) * 3; ++i) {
+            const glm::vec3& p = mesh.vertices[index[i]].position;
+            leaf.min = glm::min(leaf.min, p);
+            leaf.max = glm::max(leaf.max, p);
+        }
+    }
+
+    // Binary hierarchy over the leaves in curve order; a node's two children sit
+    // next to each other, so the tree needs 2 * clusters - 1 nodes
+    std::vector<Node>& nodes = clusters.m_nodes;
+    nodes.reserve(2 * clusterCount - 1);
+    nodes.push_back(Node());
+    struct Pending { size_t node; size_t firstCluster; size_t count; };
+    std::vector<Pending> pending{{0, 0, clusterCount}};
+    std::vector<size_t> innerNodes;
+    while (!pending.empty()) {
+        const Pending p = pending.back();
+        pending.pop_back();
+        if (p.count == 1) {
+            nodes[p.node] = leaves[p.firstCluster];
+            continue;
+        }
+        const size_t firstChild = nodes.size();
+        nodes.resize(firstChild + 2);
+        nodes[p.node].firstChild = static_cast<unsigned int>(firstChild);
+        const size_t half = p.count / 2;
+        pending.push_back({firstChild, p.firstCluster, half});
+        pending.push_back({firstChild + 1, p.firstCluster + half, p.count - half});
+        innerNodes.push_back(p.node);
+    }
+    // Children are created after their parents, so walking the inner nodes
+    // backwards sees every child finished first
+    for (auto it = innerNodes.rbegin(); it != innerNodes.rend(); ++it) {
+        Node& node = nodes[*it];
+        const Node& a = nodes[node.firstChild];
+        const Node& b = nodes[node.firstChild + 1];
+        node.min = glm::min(a.min, b.min);
+        node.max = glm::max(a.max, b.max);
+        node.firstTriangle = a.firstTriangle;
+        node.triangleCount = a.triangleCount + b.triangleCount;
+    }
+    clusters.m_clusterCount = clusterCount;
+    return clusters;
+}
+
+void MeshClusters::cull(const glm::mat4& mvp, const glm::vec2& viewportSize, float minPixels,
+                        std::vector<Range>& visible) const {
+    visible.clear();
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    // Clip planes of the view volume in model space (Gribb & Hartmann); a point
+    // is inside when dot(plane.xyz, p) + plane.w >= 0 for all six
+    const glm::vec4 row0(mvp[0][0], mvp[1][0], mvp[2][0], mvp[3][0]);
+    const glm::vec4 row1(mvp[0][1], mvp[1][1], mvp[2][1], mvp[3][1]);
+    const glm::vec4 row2(mvp[0][2], mvp[1][2], mvp[2][2], mvp[3][2]);
+    const glm::vec4 row3(mvp[0][3], mvp[1][3], mvp[2][3], mvp[3][3]);
+    const glm::vec4 planes[6] = {row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2};
+
+    // A sphere of radius r spans at most r * |row0.xyz| * width / w pixels across
+    // (likewise for y), whatever the orientation
+    const float pixelsPerUnit = std::max(glm::length(glm::vec3(row0)) * viewportSize.x,
+                                         glm::length(glm::vec3(row1)) * viewportSize.y);
+
+    auto classify = [&](const Node& node) {
+        const glm::vec3 center = (node.min + node.max) * 0.5f;
+        const glm::vec3 halfExtent = (node.max - node.min) * 0.5f;
+        Containment result = Containment::Inside;
+        for (const glm::vec4& plane : planes) {
+            const glm::vec3 n(plane);
+            const float distance = glm::dot(n, center) + plane.w;
+            const float radius = glm::dot(halfExtent, glm::abs(n));
+            if (distance + radius < 0.0f) return Containment::Outside;
+            if (distance - radius < 0.0f) result = Containment::Intersecting;
+        }
+        return result;
+    };
+    auto tooSmall = [&](const Node& node) {
+        if (minPixels <= 0.0f) return false;
+        const glm::vec3 center = (node.min + node.max) * 0.5f;
+        const float w = std::abs(glm::dot(glm::vec3(row3), center) + row3.w);
+        const float radius = glm::length(node.max - node.min) * 0.5f;
+        return radius * pixelsPerUnit < minPixels * w;
+    };
+    auto emit = [&](const Node& node) {
+        if (!visible.empty() &&
+            visible.back().firstTriangle + visible.back().triangleCount + kMaxBridgedTriangles >= node.firstTriangle) {
+            visible.back().triangleCount = node.firstTriangle + node.triangleCount - visible.back().firstTriangle;
+        } else {
+            visible.push_back({node.firstTriangle, node.triangleCount});
+        }
+    };
+
+    // Depth first, left child first, so ranges come out in index buffer order.
+    // Below a node that is entirely inside, only the size test remains.
+    struct Entry { unsigned int node; bool inside; };
+    Entry stack[64];
+    int top = 0;
+    stack[top++] = {0, false};
+    while (top > 0) {
+        const Entry entry = stack[--top];
+        const Node& node = m_nodes[entry.node];
+        bool inside = entry.inside;
+        if (!inside) {
+            const Containment c = classify(node);
+            if (c == Containment::Outside) continue;
+            inside = c == Containment::Inside;
+        }
+        if (tooSmall(node)) continue;
+        if (node.firstChild == 0 || (inside && minPixels <= 0.0f)) {
+            emit(node);
+            continue;
+        }
+        stack[top++] = {node.firstChild + 1, inside};
+        stack[top++] = {node.firstChild, inside};
+    }
+}
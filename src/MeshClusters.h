@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Mesh.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+
+// Forward declaration - can be Progress_abstract (global) or gui::Progress_abstract
+class Progress_abstract;
+
+// Spatially coherent groups of triangles for view culling. build() sorts the
+// mesh's triangles along a Morton curve through their centroids and cuts the
+// result into clusters of consecutive triangles; a bounding box hierarchy over
+// the clusters lets cull() accept or reject whole regions with one test.
+// Every node covers a contiguous triangle range, so the visible set comes out
+// as a few long ranges of the index buffer.
+class MeshClusters {
+public:
+    static constexpr unsigned int kClusterTriangles = 2048;
+    // cull() joins ranges separated by at most this many culled triangles:
+    // drawing them is cheaper than one more draw call with its uniform update
+    static constexpr unsigned int kMaxBridgedTriangles = kClusterTriangles;
+
+    // Triangles [firstTriangle, firstTriangle + triangleCount) of the mesh
+    struct Range {
+        unsigned int firstTriangle;
+        unsigned int triangleCount;
+    };
+
+    // Reorder mesh.triangleIndices / triangleFacets into cluster order and build
+    // the hierarchy. Facets, vertices and edges are not touched.
+    static MeshClusters build(Mesh& mesh, Progress_abstract* progress = nullptr);
+
+    // Replace `visible` with the triangle ranges inside the view volume of `mvp`
+    // (clip = mvp * model-space position), adjacent ranges merged and small gaps
+    // bridged (see kMaxBridgedTriangles). Clusters whose
+    // bounds span fewer than `minPixels` pixels of a `viewportSize` viewport are
+    // dropped as well; 0 keeps them.
+    void cull(const glm::mat4& mvp, const glm::vec2& viewportSize, float minPixels,
+              std::vector<Range>& visible) const;
+
+    bool empty() const { return m_nodes.empty(); }
+    size_t clusterCount() const { return m_clusterCount; }
+
+private:
+    // Children of an inner node are nodes[firstChild] and nodes[firstChild + 1]
+    struct Node {
+        glm::vec3 min;
+        glm::vec3 max;
+        unsigned int firstTriangle;
+        unsigned int triangleCount;
+        unsigned int firstChild; // 0 for leaves (the root is never a child)
+    };
+
+    std::vector<Node> m_nodes; // m_nodes[0] is the root
+    size_t m_clusterCount = 0;
+};
@@ -0,0 +1,357 @@
+#include "MeshSimplifier.h"
+#include "MeshWelder.h"
+#include "progress/Progress_abstract.h"  // Include for mySTLviewer standalone compilation
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <vector>
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+constexpr unsigned int kNoBlock = ~0u;
+constexpr unsigned int kSharedVertex = ~0u - 1;
+
+// Sum of squared distances to a set of planes, as the symmetric 4x4 matrix
+// of Garland & Heckbert (upper triangle, row by row)
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+
+    // Plane n . p + d = 0 with unit n
+    void addPlane(double x, double y, double z, double d) {
+        a00 += x * x; a01 += x * y; a02 += x * z; a03 += x * d;
+        a11 += y * y; a12 += y * z; a13 += y * d;
+        a22 += z * z; a23 += z * d;
+        a33 += d * d;
+    }
+    Quadric& operator+=(const Quadric& o) {
+        a00 += o.a00; a01 += o.a01; a02 += o.a02; a03 += o.a03;
+        a11 += o.a11; a12 += o.a12; a13 += o.a13;
+        a22 += o.a22; a23 += o.a23;
+        a33 += o.a33;
+        return *this;
+    }
+    double evaluate(const glm::vec3& p) const {
+        const double x = p.x, y = p.y, z = p.z;
+        return a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x +
+               a11 * y * y + 2 * a12 * y * z + 2 * a13 * y +
+               a22 * z * z + 2 * a23 * z + a33;
+    }
+};
+
+// Move vertex `from` onto vertex `to`; valid while neither has changed since
+struct Collapse {
+    double cost;
+    unsigned int from;
+    unsigned int to;
+    unsigned int fromStamp;
+    unsigned int toStamp;
+};
+
+// Orders the priority queue cheapest first, ties by vertex, so the result is deterministic
+struct CostlierThan {
+    bool operator()(const Collapse& a, const Collapse& b) const {
+        if (a.cost != b.cost) return a.cost > b.cost;
+        return a.from != b.from ? a.from > b.from : a.to > b.to;
+    }
+};
+
+struct BlockResult {
+    std::vector<unsigned int> indices; // global vertex indices
+    double maxCost = 0.0;
+};
+
+// Collapse edges of one block of triangles until `target` triangles are left
+// or no allowed collapse remains
+BlockResult simplifyBlock(const Mesh& mesh, const unsigned int* indices, size_t triangleCount,
+                          const std::vector<unsigned int>& owner, size_t target, Progress_abstract* progress) {
+    BlockResult result;
+    if (progress && progress->isCancelled()) {
+        return result;
+    }
+
+    // Block-local vertex numbering
+    std::vector<unsigned int> globalIds(indices, indices + triangleCount * 3);
+    std::sort(globalIds.begin(), globalIds.end());
+    globalIds.erase(std::unique(globalIds.begin(), globalIds.end()), globalIds.end());
+    const size_t vertexCount = globalIds.size();
+    auto localId = [&](unsigned int global) {
+        return static_cast<unsigned int>(std::lower_bound(globalIds.begin(), globalIds.end(), global) - globalIds.begin());
+    };
+
+    std::vector<std::array<unsigned int, 3>> triangles(triangleCount);
+    std::vector<glm::vec3> originalNormals(triangleCount, glm::vec3(0.0f));
+    std::vector<char> alive(triangleCount, 1);
+    std::vector<glm::vec3> positions(vertexCount);
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<char> locked(vertexCount, 0);
+    std::vector<char> removed(vertexCount, 0);
+    std::vector<unsigned int> stamps(vertexCount, 0);
+    std::vector<std::vector<unsigned int>> vertexTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        positions[v] = mesh.vertices[globalIds[v]].position;
+        locked[v] = owner[globalIds[v]] == kSharedVertex;
+    }
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (int k = 0; k < 3; ++k) {
+            triangles[t][k] = localId(indices[3 * t + k]);
+            vertexTriangles[triangles[t][k]].push_back(static_cast<unsigned int>(t));
+        }
+        const glm::vec3& p0 = positions[triangles[t][0]];
+        glm::vec3 n = glm::cross(positions[triangles[t][1]] - p0, positions[triangles[t][2]] - p0);
+        const float length = glm::length(n);
+        if (length <= 0.0f) continue;
+        n /= length;
+        originalNormals[t] = n;
+        const double d = -glm::dot(n, p0);
+        for (int k = 0; k < 3; ++k) {
+            quadrics[triangles[t][k]].addPlane(n.x, n.y, n.z, d);
+        }
+    }
+
+    // Edges used by one triangle (open boundary or block border) or by more than
+    // two (non-manifold) keep both end points, so the outline cannot shrink
+    std::vector<uint64_t> edges;
+    edges.reserve(triangleCount * 3);
+    for (const auto& tri : triangles) {
+        for (int k = 0; k < 3; ++k) {
+            const unsigned int a = std::min(tri[k], tri[(k + 1) % 3]);
+            const unsigned int b = std::max(tri[k], tri[(k + 1) % 3]);
+            edges.push_back(static_cast<uint64_t>(a) << 32 | b);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::priority_queue<Collapse, std::vector<Collapse>, CostlierThan> queue;
+    auto pushCandidate = [&](unsigned int a, unsigned int b) {
+        if (locked[a] && locked[b]) return;
+        Quadric q = quadrics[a];
+        q += quadrics[b];
+        const double infinity = std::numeric_limits<double>::infinity();
+        const double costAtoB = locked[a] ? infinity : q.evaluate(positions[b]);
+        const double costBtoA = locked[b] ? infinity : q.evaluate(positions[a]);
+        if (costAtoB <= costBtoA) {
+            queue.push({std::max(costAtoB, 0.0), a, b, stamps[a], stamps[b]});
+        } else {
+            queue.push({std::max(costBtoA, 0.0), b, a, stamps[b], stamps[a]});
+        }
+    };
+    for (size_t i = 0; i < edges.size();) {
+        size_t end = i + 1;
+        while (end < edges.size() && edges[end] == edges[i]) ++end;
+        const unsigned int a = static_cast<unsigned int>(edges[i] >> 32);
+        const unsigned int b = static_cast<unsigned int>(edges[i]);
+        if (end - i != 2) {
+            locked[a] = 1;
+            locked[b] = 1;
+        }
+        i = end;
+    }
+    for (size_t i = 0; i < edges.size(); ++i) {
+        if (i > 0 && edges[i] == edges[i - 1]) continue;
+        pushCandidate(static_cast<unsigned int>(edges[i] >> 32), static_cast<unsigned int>(edges[i]));
+    }
+    std::vector<uint64_t>().swap(edges);
+
+    auto ring = [&](unsigned int v, unsigned int skip, std::vector<unsigned int>& out) {
+        out.clear();
+        for (unsigned int t : vertexTriangles[v]) {
+            if (!alive[t]) continue;
+            for (unsigned int u : triangles[t]) {
+                if (u != v && u != skip) out.push_back(u);
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+    };
+
+    size_t liveTriangles = triangleCount;
+    std::vector<unsigned int> ringFrom, ringTo, common;
+    size_t iterations = 0;
+    while (liveTriangles > target && !queue.empty()) {
+        if ((++iterations & 4095) == 0 && progress && progress->isCancelled()) break;
+        const Collapse c = queue.top();
+        queue.pop();
+        if (removed[c.from] || removed[c.to] || stamps[c.from] != c.fromStamp || stamps[c.to] != c.toStamp) {
+            continue;
+        }
+
+        // Link condition: the two vertices may only share the neighbours of the
+        // triangles on their common edge, or the collapse pinches the surface
+        size_t sharedTriangles = 0;
+        for (unsigned int t : vertexTriangles[c.from]) {
+            if (alive[t] && (triangles[t][0] == c.to || triangles[t][1] == c.to || triangles[t][2] == c.to)) {
+                ++sharedTriangles;
+            }
+        }
+        if (sharedTriangles == 0) continue;
+        ring(c.from, c.to, ringFrom);
+        ring(c.to, c.from, ringTo);
+        common.clear();
+        std::set_intersection(ringFrom.begin(), ringFrom.end(), ringTo.begin(), ringTo.end(), std::back_inserter(common));
+        if (common.size() != sharedTriangles) continue;
+
+        // No surviving triangle may degenerate or turn by more than 60 degrees, nor
+        // face away from its original orientation after several collapses
+        bool folds = false;
+        for (unsigned int t : vertexTriangles[c.from]) {
+            if (!alive[t]) continue;
+            const auto& tri = triangles[t];
+            if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) continue;
+            glm::vec3 p[3];
+            glm::vec3 moved[3];
+            for (int k = 0; k < 3; ++k) {
+                p[k] = positions[tri[k]];
+                moved[k] = tri[k] == c.from ? positions[c.to] : p[k];
+            }
+            const glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+            const glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+            const float lengths = glm::length(before) * glm::length(after);
+            if (!(lengths > 0.0f) || glm::dot(before, after) < 0.5f * lengths ||
+                glm::dot(originalNormals[t], after) <= 0.0f) {
+                folds = true;
+                break;
+            }
+        }
+        if (folds) continue;
+
+        for (unsigned int t : vertexTriangles[c.from]) {
+            if (!alive[t]) continue;
+            auto& tri = triangles[t];
+            if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+                alive[t] = 0;
+                --liveTriangles;
+            } else {
+                for (unsigned int& v : tri) {
+                    if (v == c.from) v = c.to;
+                }
+                vertexTriangles[c.to].push_back(t);
+            }
+        }
+        removed[c.from] = 1;
+        std::vector<unsigned int>().swap(vertexTriangles[c.from]);
+        quadrics[c.to] += quadrics[c.from];
+        ++stamps[c.to];
+        result.maxCost = std::max(result.maxCost, c.cost);
+
+        // Every edge at `to` has a new cost; the queued ones are stale now
+        std::vector<unsigned int>& toTriangles = vertexTriangles[c.to];
+        toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(),
+                                         [&](unsigned int t) { return !alive[t]; }),
+                          toTriangles.end());
+        ring(c.to, c.to, ringTo);
+        for (unsigned int n : ringTo) {
+            pushCandidate(c.to, n);
+        }
+    }
+
+    result.indices.reserve(liveTriangles * 3);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (!alive[t]) continue;
+        for (unsigned int v : triangles[t]) {
+            result.indices.push_back(globalIds[v]);
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+std::vector<MeshSimplifier::Level> MeshSimplifier::buildLevels(const Mesh& mesh, size_t minTriangles,
+                                                               Progress_abstract* progress) {
+    std::vector<Level> levels;
+    if (mesh.triangleIndices.size() / 3 / 4 < std::max<size_t>(minTriangles, 1)) {
+        return levels;
+    }
+
+    if (progress) {
+        progress->setMessage("Building levels of detail...");
+        progress->setProgress(0.0f);
+    }
+
+    // Work on representative vertices so that triangles of unwelded meshes are connected
+    const std::vector<unsigned int> representative = MeshWelder::findRepresentatives(mesh);
+    std::vector<unsigned int> current;
+    current.reserve(mesh.triangleIndices.size());
+    for (size_t i = 0; i + 2 < mesh.triangleIndices.size(); i += 3) {
+        const unsigned int a = representative[mesh.triangleIndices[i]];
+        const unsigned int b = representative[mesh.triangleIndices[i + 1]];
+        const unsigned int c = representative[mesh.triangleIndices[i + 2]];
+        if (a == b || b == c || a == c) continue;
+        current.insert(current.end(), {a, b, c});
+    }
+
+    std::vector<unsigned int> owner(mesh.vertices.size(), kNoBlock);
+    double error = 0.0;
+    const size_t fullTriangles = mesh.triangleIndices.size() / 3;
+    while (current.size() / 3 / 4 >= minTriangles) {
+        const size_t triangleCount = current.size() / 3;
+        const size_t blockCount = (triangleCount + kBlockTriangles - 1) / kBlockTriangles;
+
+        // Vertices used by more than one block must not move
+        for (size_t t = 0; t < triangleCount; ++t) {
+            const unsigned int block = static_cast<unsigned int>(t / kBlockTriangles);
+            for (int k = 0; k < 3; ++k) {
+                unsigned int& o = owner[current[3 * t + k]];
+                if (o == kNoBlock) o = block;
+                else if (o != block) o = kSharedVertex;
+            }
+        }
+
+        std::vector<BlockResult> blocks(blockCount);
+#ifdef HAVE_OPENMP
+        #pragma omp parallel for schedule(dynamic, 1)
+#endif
+        for (long long b = 0; b < static_cast<long long>(blockCount); ++b) {
+            const size_t first = static_cast<size_t>(b) * kBlockTriangles;
+            const size_t count = std::min(kBlockTriangles, triangleCount - first);
+            blocks[b] = simplifyBlock(mesh, current.data() + 3 * first, count, owner, count / 4, progress);
+        }
+        for (unsigned int v : current) {
+            owner[v] = kNoBlock;
+        }
+        if (progress && progress->isCancelled()) {
+            return {};
+        }
+
+        Level level;
+        double maxCost = 0.0;
+        size_t indexCount = 0;
+        for (const BlockResult& block : blocks) {
+            indexCount += block.indices.size();
+        }
+        level.triangleIndices.reserve(indexCount);
+        for (const BlockResult& block : blocks) {
+            level.triangleIndices.insert(level.triangleIndices.end(), block.indices.begin(), block.indices.end());
+            maxCost = std::max(maxCost, block.maxCost);
+        }
+        // Locked borders and folds can stall the reduction; such a level costs memory for little gain
+        if (level.triangleIndices.size() > current.size() * 7 / 10) {
+            break;
+        }
+        // A collapse moves the surface by at most sqrt(cost) from each of the planes it
+        // accumulated; the distances of successive levels add up
+        error += std::sqrt(maxCost);
+        level.error = static_cast<float>(error);
+        current = level.triangleIndices;
+        levels.push_back(std::move(level));
+
+        if (progress) {
+            progress->setProgress(1.0f - static_cast<float>(current.size() / 3) / fullTriangles);
+        }
+    }
+
+    if (progress) {
+        progress->setMessage("Levels of detail complete");
+        progress->setProgress(1.0f);
+    }
+    return levels;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Mesh.h"
+#include <cstddef>
+#include <vector>
+
+// Forward declaration - can be Progress_abstract (global) or gui::Progress_abstract
+class Progress_abstract;
+
+// Levels of detail by quadric error metric edge collapse (Garland & Heckbert).
+// Only half-edge collapses are made, moving one vertex onto another, so every
+// level indexes the mesh's own vertex array and can share its vertex buffer.
+// Each level is simplified from the previous one in blocks of consecutive
+// triangles, in parallel; vertices on block borders and on open or
+// non-manifold edges stay put, so blocks never tear apart. Blocks keep the same
+// number of triangles at every level and therefore cover more of the surface
+// each time, so the borders of one level are interior at the next.
+class MeshSimplifier {
+public:
+    struct Level {
+        std::vector<unsigned int> triangleIndices; // 3 vertex indices per triangle
+        float error = 0.0f; // bound on the distance to the full mesh, in model units
+    };
+
+    static constexpr size_t kBlockTriangles = 65536;
+
+    // Successive levels of about a quarter of the previous one's triangles,
+    // stopping before a level would drop below `minTriangles` or when
+    // collapses stop paying off. Coincident vertices are treated as one, so
+    // unwelded meshes simplify too. Returns no levels if cancelled.
+    static std::vector<Level> buildLevels(const Mesh& mesh, size_t minTriangles,
+                                          Progress_abstract* progress = nullptr);
+};
@@ -0,0 +1,137 @@
+#include "MeshTriangulator.h"
+#include <mapbox/earcut.hpp>
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+// Facets per dynamic-schedule chunk; n-gons vary a lot in cost, so batches stay small
+constexpr int kFacetsPerChunk = 1024;
+}
+
+// Reused across all facets of one thread, so earcut's ring and output buffers
+// are allocated once per thread instead of once per facet
+struct MeshTriangulator::EarcutScratch {
+    using Point = std::array<double, 2>;
+    std::vector<std::vector<Point>> polygon{1};
+    mapbox::detail::Earcut<unsigned int> earcut;
+};
+
+glm::vec3 MeshTriangulator::facetCenter(const Mesh& mesh, const FacetView& facet) {
+    glm::vec3 center(0.0f);
+    for (unsigned int idx : facet) {
+        center += mesh.vertices[idx].position;
+    }
+    return center / static_cast<float>(facet.size());
+}
+
+glm::vec3 MeshTriangulator::facetNormal(const Mesh& mesh, const FacetView& facet) {
+    const size_t n = facet.size();
+
+    // Compute a robust facet normal via Newell's method
+    glm::vec3 normal(0.0f);
+    for (size_t i = 0; i < n; ++i) {
+        const glm::vec3& v1 = mesh.vertices[facet[i]].position;
+        const glm::vec3& v2 = mesh.vertices[facet[(i + 1) % n]].position;
+        normal.x += (v1.y - v2.y) * (v1.z + v2.z);
+        normal.y += (v1.z - v2.z) * (v1.x + v2.x);
+        normal.z += (v1.x - v2.x) * (v1.y + v2.y);
+    }
+    if (glm::length(normal) < 1e-8f) {
+        // Fallback to first triangle cross if Newell's degenerate
+        const glm::vec3 a = mesh.vertices[facet[0]].position;
+        const glm::vec3 b = mesh.vertices[facet[1]].position;
+        const glm::vec3 c = mesh.vertices[facet[2]].position;
+        normal = glm::cross(b - a, c - a);
+    }
+    if (glm::length(normal) > 1e-8f) {
+        normal = glm::normalize(normal);
+    }
+    return normal;
+}
+
+void MeshTriangulator::triangulate(Mesh& mesh) {
+    const size_t facetCount = mesh.facets.size();
+
+    // Pass 1: each n-gon becomes exactly n - 2 triangles, so every facet's
+    // output slice is known before any triangulation runs
+    std::vector<size_t> firstTriangle(facetCount + 1);
+    firstTriangle[0] = 0;
+    for (size_t f = 0; f < facetCount; ++f) {
+        const size_t n = mesh.facets.offsets[f + 1] - mesh.facets.offsets[f];
+        firstTriangle[f + 1] = firstTriangle[f] + (n >= 3 ? n - 2 : 0); // Skip degenerate facets
+    }
+    const size_t triangleCount = firstTriangle[facetCount];
+    mesh.triangleIndices.resize(triangleCount * 3);
+    mesh.triangleFacets.resize(triangleCount);
+
+    // Pass 2: facets are independent and each writes only its own slice, so the
+    // result is identical to a serial run whatever the thread count
+#ifdef HAVE_OPENMP
+    #pragma omp parallel if (facetCount > static_cast<size_t>(kFacetsPerChunk))
+#endif
+    {
+        EarcutScratch scratch;
+#ifdef HAVE_OPENMP
+        #pragma omp for schedule(dynamic, kFacetsPerChunk)
+#endif
+        for (long long f = 0; f < static_cast<long long>(facetCount); ++f) {
+            const size_t first = firstTriangle[f];
+            const size_t count = firstTriangle[f + 1] - first;
+            if (count == 0) continue;
+            std::fill_n(mesh.triangleFacets.begin() + first, count, static_cast<unsigned int>(f));
+            triangulateFacet(mesh, mesh.facets[f], mesh.triangleIndices.data() + first * 3, scratch);
+        }
+    }
+}
+
+void MeshTriangulator::triangulateFacet(const Mesh& mesh, const FacetView& facet, unsigned int* out,
+                                        EarcutScratch& scratch) {
+    const size_t n = facet.size();
+    if (n == 3) {
+        out[0] = facet[0];
+        out[1] = facet[1];
+        out[2] = facet[2];
+        return;
+    }
+
+    // For polygons with more than 3 vertices, triangulate by projecting onto the facet plane
+    const glm::vec3 normal = facetNormal(mesh, facet);
+
+    // Build a local 2D basis on the facet plane
+    // Choose an up vector not parallel to the facet normal
+    glm::vec3 up = (std::abs(normal.z) < 0.9f) ? glm::vec3(0,0,1) : glm::vec3(0,1,0);
+    glm::vec3 tangent = glm::normalize(glm::cross(up, normal));
+    glm::vec3 bitangent = glm::normalize(glm::cross(normal, tangent));
+    // Use centroid as origin for numerical stability
+    const glm::vec3 centroid = facetCenter(mesh, facet);
+    std::vector<EarcutScratch::Point>& ring = scratch.polygon[0];
+    ring.clear();
+    for (unsigned int idx : facet) {
+        glm::vec3 p = mesh.vertices[idx].position - centroid;
+        double u = static_cast<double>(glm::dot(p, tangent));
+        double v = static_cast<double>(glm::dot(p, bitangent));
+        ring.push_back(EarcutScratch::Point{u, v});
+    }
+
+    scratch.earcut(scratch.polygon);
+    const std::vector<unsigned int>& localIndices = scratch.earcut.indices;
+
+    if (localIndices.size() != (n - 2) * 3) {
+        // Fallback: simple triangle fan around vertex 0
+        for (size_t j = 1; j + 1 < n; ++j) {
+            *out++ = facet[0];
+            *out++ = facet[j];
+            *out++ = facet[j + 1];
+        }
+    } else {
+        // Map local earcut indices back to the facet's global vertex indices
+        for (unsigned int local : localIndices) {
+            *out++ = facet[local];
+        }
+    }
+}
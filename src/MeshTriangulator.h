@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Mesh.h"
+
+// Turns the polygonal facets of a Mesh into the triangles the renderer draws:
+// Mesh::triangleIndices / triangleFacets (plane-projected earcut, triangle fan
+// fallback). The wireframe edges come from EdgeExtractor.
+class MeshTriangulator {
+public:
+    // Fill triangleIndices and triangleFacets from mesh.facets
+    static void triangulate(Mesh& mesh);
+    
+    // Facet normal via Newell's method with a cross-product fallback (unit length
+    // unless the facet is degenerate)
+    static glm::vec3 facetNormal(const Mesh& mesh, const FacetView& facet);
+    static glm::vec3 facetCenter(const Mesh& mesh, const FacetView& facet);
+    
+private:
+    struct EarcutScratch;
+    
+    // Write the n - 2 triangles of `facet` to out[0 .. 3 * (n - 2))
+    static void triangulateFacet(const Mesh& mesh, const FacetView& facet, unsigned int* out,
+                                 EarcutScratch& scratch);
+};
@@ -0,0 +1,283 @@
+#include "MeshWelder.h"
+#include "ParallelSort.h"
+#include "progress/Progress_abstract.h"  // Include for mySTLviewer standalone compilation
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+// Spatial hash entry; entries sorted by (key, index) form the hash buckets,
+// each bucket listing its vertices in ascending index order
+struct CellEntry {
+    uint64_t key;
+    unsigned int index;
+};
+
+inline bool operator<(const CellEntry& a, const CellEntry& b) {
+    return a.key != b.key ? a.key < b.key : a.index < b.index;
+}
+
+inline uint64_t mix64(uint64_t h) {
+    // splitmix64 finalizer
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h;
+}
+
+inline uint64_t hashCell(int64_t x, int64_t y, int64_t z) {
+    uint64_t h = mix64(static_cast<uint64_t>(x));
+    h = mix64(h ^ static_cast<uint64_t>(y));
+    return mix64(h ^ static_cast<uint64_t>(z));
+}
+
+inline uint64_t hashExact(const glm::vec3& p) {
+    // + 0.0f folds -0 into +0 so both land in the same bucket
+    uint32_t bits[3];
+    float coords[3] = {p.x + 0.0f, p.y + 0.0f, p.z + 0.0f};
+    std::memcpy(bits, coords, sizeof(bits));
+    return hashCell(bits[0], bits[1], bits[2]);
+}
+
+// Open-addressing table from bucket key to the bucket's first entry
+class BucketTable {
+public:
+    explicit BucketTable(const std::vector<CellEntry>& entries) {
+        size_t buckets = 0;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (i == 0 || entries[i].key != entries[i - 1].key) ++buckets;
+        }
+        size_t capacity = 16;
+        while (capacity < buckets * 2) capacity *= 2;
+        m_mask = capacity - 1;
+        m_keys.resize(capacity);
+        m_starts.assign(capacity, kEmpty);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (i != 0 && entries[i].key == entries[i - 1].key) continue;
+            size_t slot = entries[i].key & m_mask;
+            while (m_starts[slot] != kEmpty) slot = (slot + 1) & m_mask;
+            m_keys[slot] = entries[i].key;
+            m_starts[slot] = static_cast<unsigned int>(i);
+        }
+    }
+
+    // Index of the first entry with this key, or kEmpty
+    unsigned int find(uint64_t key) const {
+        size_t slot = key & m_mask;
+        while (m_starts[slot] != kEmpty) {
+            if (m_keys[slot] == key) return m_starts[slot];
+            slot = (slot + 1) & m_mask;
+        }
+        return kEmpty;
+    }
+
+    static constexpr unsigned int kEmpty = 0xFFFFFFFFu;
+
+private:
+    std::vector<uint64_t> m_keys;
+    std::vector<unsigned int> m_starts;
+    size_t m_mask = 0;
+};
+
+struct CellCoord {
+    int64_t x, y, z;
+};
+
+// Cell index along one axis. findRepresentatives keeps the grid within
+// 2^40 cells of the origin; the clamp only catches non-finite positions,
+// whose conversion to an integer would be undefined
+inline int64_t cellIndex(float scaled) {
+    const float limit = 0x1p62f;
+    if (!(scaled >= -limit && scaled <= limit)) {
+        return scaled > 0.0f ? static_cast<int64_t>(limit) : scaled < 0.0f ? -static_cast<int64_t>(limit) : 0;
+    }
+    return static_cast<int64_t>(std::floor(scaled));
+}
+
+inline CellCoord cellOf(const glm::vec3& p, const glm::vec3& origin, float invCellSize) {
+    glm::vec3 c = (p - origin) * invCellSize;
+    return {cellIndex(c.x), cellIndex(c.y), cellIndex(c.z)};
+}
+
+} // namespace
+
+std::vector<unsigned int> MeshWelder::findRepresentatives(const Mesh& mesh, float epsilon) {
+    const size_t n = mesh.vertices.size();
+    const bool exact = !(epsilon > 0.0f);
+    // Cells no finer than 2^-40 of the extent, so cell coordinates stay far
+    // from the int64 range however small the requested epsilon (at that
+    // scale float positions are as good as exact anyway)
+    if (!exact) {
+        epsilon = std::max(epsilon, mesh.getMaxExtent() * 0x1p-41f);
+    }
+    // Any origin gives a correct grid; the bounding box corner keeps the cell coordinates small
+    const glm::vec3 origin = mesh.min_bounds;
+    // Cells are 2 * epsilon wide, so everything within epsilon of a point lies in
+    // its own cell or the neighbour on the nearer side along each axis (8 cells)
+    const float invCellSize = exact ? 0.0f : 0.5f / epsilon;
+    const float epsilon2 = epsilon * epsilon;
+
+    // Bucket every vertex by its cell (or exact position)
+    std::vector<CellEntry> entries(n);
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (long long i = 0; i < static_cast<long long>(n); ++i) {
+        const glm::vec3& p = mesh.vertices[i].position;
+        uint64_t key;
+        if (exact) {
+            key = hashExact(p);
+        } else {
+            CellCoord c = cellOf(p, origin, invCellSize);
+            key = hashCell(c.x, c.y, c.z);
+        }
+        entries[i] = {key, static_cast<unsigned int>(i)};
+    }
+
+    parallelSort(entries, [](const CellEntry& a, const CellEntry& b) { return a < b; });
+
+    const BucketTable buckets(entries);
+
+    // For each vertex find the lowest index within epsilon in its own and
+    // neighbouring cells; only reads shared data, so it runs in parallel
+    std::vector<unsigned int> representative(n);
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 4096)
+#endif
+    for (long long i = 0; i < static_cast<long long>(n); ++i) {
+        const glm::vec3& p = mesh.vertices[i].position;
+        unsigned int best = static_cast<unsigned int>(i);
+
+        auto scanBucket = [&](uint64_t key) {
+            unsigned int start = buckets.find(key);
+            if (start == BucketTable::kEmpty) return;
+            for (auto it = entries.begin() + start; it != entries.end() && it->key == key && it->index < best; ++it) {
+                const glm::vec3& q = mesh.vertices[it->index].position;
+                if (exact) {
+                    if (q == p) {
+                        best = it->index;
+                        break;
+                    }
+                } else {
+                    glm::vec3 d = q - p;
+                    if (glm::dot(d, d) <= epsilon2) {
+                        best = it->index;
+                        break;
+                    }
+                }
+            }
+        };
+
+        if (exact) {
+            scanBucket(hashExact(p));
+        } else {
+            glm::vec3 scaled = (p - origin) * invCellSize;
+            CellCoord c = cellOf(p, origin, invCellSize);
+            // Step towards the nearer neighbour along each axis
+            const int sx = (scaled.x - static_cast<float>(c.x) < 0.5f) ? -1 : 1;
+            const int sy = (scaled.y - static_cast<float>(c.y) < 0.5f) ? -1 : 1;
+            const int sz = (scaled.z - static_cast<float>(c.z) < 0.5f) ? -1 : 1;
+            for (int k = 0; k < 8; ++k) {
+                scanBucket(hashCell(c.x + ((k & 1) ? sx : 0),
+                                    c.y + ((k & 2) ? sy : 0),
+                                    c.z + ((k & 4) ? sz : 0)));
+            }
+        }
+        representative[i] = best;
+    }
+
+    // Resolve chains (representative[i] <= i, so one ascending pass suffices)
+    for (size_t i = 0; i < n; ++i) {
+        representative[i] = representative[representative[i]];
+    }
+    return representative;
+}
+
+MeshWelder::Result MeshWelder::weld(Mesh& mesh, float epsilon, Progress_abstract* progress) {
+    Result result;
+    const size_t n = mesh.vertices.size();
+    if (n == 0) {
+        return result;
+    }
+
+    if (progress) {
+        progress->setMessage("Welding vertices...");
+        progress->setProgress(0.0f);
+    }
+
+    mesh.calculateBounds();
+    const std::vector<unsigned int> representative = findRepresentatives(mesh, epsilon);
+
+    if (progress) progress->setProgress(0.8f);
+
+    // Compact the kept vertices in place
+    std::vector<unsigned int> remap(n);
+    unsigned int kept = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const unsigned int r = representative[i];
+        if (r == i) {
+            remap[i] = kept;
+            mesh.vertices[kept] = mesh.vertices[i];
+            ++kept;
+        } else {
+            remap[i] = remap[r];
+        }
+    }
+    result.verticesRemoved = n - kept;
+    mesh.vertices.resize(kept);
+    mesh.vertices.shrink_to_fit();
+
+    // Rewrite facet indices
+    std::vector<unsigned int>& indices = mesh.facets.indices;
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for (long long i = 0; i < static_cast<long long>(indices.size()); ++i) {
+        indices[i] = remap[indices[i]];
+    }
+
+    // Drop repeated consecutive vertices and facets left with fewer than 3
+    std::vector<unsigned int>& offsets = mesh.facets.offsets;
+    const size_t facetCount = mesh.facets.size();
+    size_t out = 0;
+    size_t keptFacets = 0;
+    // Compacted offsets overwrite the originals in place, up to offsets[f + 1]:
+    // each facet's original end is read before that and carried over as the next begin
+    size_t end = offsets[0];
+    for (size_t f = 0; f < facetCount; ++f) {
+        const size_t begin = end;
+        end = offsets[f + 1];
+        const size_t facetStart = out;
+        for (size_t k = begin; k < end; ++k) {
+            if (out == facetStart || indices[out - 1] != indices[k]) {
+                indices[out++] = indices[k];
+            }
+        }
+        while (out - facetStart > 1 && indices[out - 1] == indices[facetStart]) {
+            --out;
+        }
+        if (out - facetStart < 3) {
+            out = facetStart;
+            continue;
+        }
+        offsets[++keptFacets] = static_cast<unsigned int>(out);
+    }
+    result.facetsRemoved = facetCount - keptFacets;
+    indices.resize(out);
+    offsets.resize(keptFacets + 1);
+    mesh.clearTriangulation();
+
+    mesh.calculateBounds();
+
+    if (progress) {
+        progress->setMessage("Welding complete");
+        progress->setProgress(1.0f);
+    }
+
+    return result;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Mesh.h"
+#include <cstddef>
+#include <vector>
+
+// Forward declaration - can be Progress_abstract (global) or gui::Progress_abstract
+class Progress_abstract;
+
+// Merges coincident vertices so that facets share them (STL files store three
+// private vertices per triangle). Facet indices are rewritten in place.
+class MeshWelder {
+public:
+    struct Result {
+        size_t verticesRemoved = 0;
+        size_t facetsRemoved = 0; // facets that collapsed to fewer than 3 distinct vertices
+    };
+
+    // Merge vertices whose positions are within `epsilon` of each other
+    // (epsilon == 0 merges bit-identical positions only). The lowest-indexed
+    // vertex of each group is kept, so the result does not depend on thread count.
+    static Result weld(Mesh& mesh, float epsilon = 0.0f, Progress_abstract* progress = nullptr);
+
+    // Without changing the mesh: for every vertex, the lowest vertex index it
+    // would be welded into (itself if none), using the same rules as weld()
+    static std::vector<unsigned int> findRepresentatives(const Mesh& mesh, float epsilon = 0.0f);
+};
@@ -0,0 +1,218 @@
+#include "OffscreenContext.h"
+#include <SDL3/SDL.h>
+#include <glad/glad.h>
+#include <cstring>
+#include <iostream>
+#ifdef HAVE_EGL
+// Keep Xlib (and its None/Bool/Status macros) out of this translation unit
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace {
+
+// Print the version and reject anything older than the 3.3 core the shaders need
+bool checkGLVersion() {
+    GLint glMajor = 0, glMinor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &glMajor);
+    glGetIntegerv(GL_MINOR_VERSION, &glMinor);
+    std::cout << "OpenGL " << glGetString(GL_VERSION) << " (" << glGetString(GL_RENDERER) << ")" << std::endl;
+    if (glMajor < 3 || (glMajor == 3 && glMinor < 3)) {
+        std::cerr << "Error: OpenGL 3.3 or newer is required. Detected " << glMajor << "." << glMinor << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#ifdef HAVE_EGL
+bool hasExtension(const char* extensions, const char* name) {
+    if (!extensions) return false;
+    const size_t length = std::strlen(name);
+    for (const char* p = std::strstr(extensions, name); p; p = std::strstr(p + length, name)) {
+        if ((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+} // namespace
+
+OffscreenContext::~OffscreenContext() {
+    destroy();
+}
+
+bool OffscreenContext::create(bool debug) {
+    destroy();
+#ifdef HAVE_EGL
+    if (createEGL(debug)) {
+        return true;
+    }
+    std::cerr << "EGL offscreen context unavailable, trying a hidden window" << std::endl;
+#endif
+    return createSDL(debug);
+}
+
+bool OffscreenContext::createEGL(bool debug) {
+#ifdef HAVE_EGL
+    // Surfaceless platform first: no X11 or Wayland connection, works in containers and CI
+    EGLDisplay display = EGL_NO_DISPLAY;
+    bool surfaceless = false;
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        surfaceless = display != EGL_NO_DISPLAY && eglInitialize(display, nullptr, nullptr);
+        if (!surfaceless) {
+            display = EGL_NO_DISPLAY;
+        }
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+            std::cerr << "EGL initialization failed: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+            return false;
+        }
+    }
+    m_eglDisplay = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL has no desktop OpenGL: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        destroy();
+        return false;
+    }
+
+    // A pbuffer-capable config, needed when the context cannot go surfaceless
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        config = nullptr;
+    }
+    const char* displayExtensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!config && !hasExtension(displayExtensions, "EGL_KHR_no_config_context")) {
+        std::cerr << "EGL offers no OpenGL config" << std::endl;
+        destroy();
+        return false;
+    }
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_CONTEXT_OPENGL_DEBUG, debug ? EGL_TRUE : EGL_FALSE,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT,
+                                          contextAttributes);
+    if (context == EGL_NO_CONTEXT) {
+        std::cerr << "EGL context creation failed: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+        destroy();
+        return false;
+    }
+    m_eglContext = context;
+
+    // All rendering goes to framebuffer objects, so no surface is needed where
+    // the driver allows it; a 1x1 pbuffer stands in elsewhere
+    const bool noSurface = hasExtension(displayExtensions, "EGL_KHR_surfaceless_context") &&
+                           eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+    if (!noSurface) {
+        const EGLint pbufferAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+        EGLSurface surface = config ? eglCreatePbufferSurface(display, config, pbufferAttributes) : EGL_NO_SURFACE;
+        if (surface == EGL_NO_SURFACE || !eglMakeCurrent(display, surface, surface, context)) {
+            std::cerr << "EGL make current failed: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+            if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+            destroy();
+            return false;
+        }
+        m_eglSurface = surface;
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        destroy();
+        return false;
+    }
+    if (!checkGLVersion()) {
+        destroy();
+        return false;
+    }
+    m_backendName = !noSurface ? "EGL pbuffer" : surfaceless ? "EGL surfaceless" : "EGL";
+    return true;
+#else
+    (void)debug;
+    return false;
+#endif
+}
+
+bool OffscreenContext::createSDL(bool debug) {
+    if (!SDL_Init(SDL_INIT_VIDEO)) {
+        std::cerr << "SDL initialization failed: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    m_sdlInitialized = true;
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    if (debug) {
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+    }
+
+    m_window = SDL_CreateWindow("STL Viewer", 16, 16, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (!m_window) {
+        std::cerr << "Window creation failed: " << SDL_GetError() << std::endl;
+        destroy();
+        return false;
+    }
+    m_sdlContext = SDL_GL_CreateContext(m_window);
+    if (!m_sdlContext) {
+        std::cerr << "OpenGL context creation failed: " << SDL_GetError() << std::endl;
+        destroy();
+        return false;
+    }
+    if (!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        destroy();
+        return false;
+    }
+    if (!checkGLVersion()) {
+        destroy();
+        return false;
+    }
+    m_backendName = "hidden SDL window";
+    return true;
+}
+
+void OffscreenContext::destroy() {
+#ifdef HAVE_EGL
+    if (m_eglDisplay) {
+        EGLDisplay display = static_cast<EGLDisplay>(m_eglDisplay);
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (m_eglSurface) eglDestroySurface(display, static_cast<EGLSurface>(m_eglSurface));
+        if (m_eglContext) eglDestroyContext(display, static_cast<EGLContext>(m_eglContext));
+        eglTerminate(display);
+    }
+#endif
+    m_eglDisplay = m_eglContext = m_eglSurface = nullptr;
+    if (m_sdlContext) {
+        SDL_GL_DestroyContext(m_sdlContext);
+        m_sdlContext = nullptr;
+    }
+    if (m_window) {
+        SDL_DestroyWindow(m_window);
+        m_window = nullptr;
+    }
+    if (m_sdlInitialized) {
+        SDL_Quit();
+        m_sdlInitialized = false;
+    }
+    m_backendName = "";
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+struct SDL_Window;
+struct SDL_GLContextState;
+
+// An OpenGL 3.3 core context without a visible window, for rendering into
+// framebuffer objects only (see ThumbnailRenderer). Built with EGL (HAVE_EGL)
+// it needs no display server at all: EGL's surfaceless platform where the
+// driver offers it (Mesa, including the llvmpipe software rasterizer), the
+// default display with a tiny pbuffer otherwise. Without EGL it falls back to
+// a hidden SDL window. The context stays current on the creating thread.
+class OffscreenContext {
+public:
+    OffscreenContext() = default;
+    ~OffscreenContext();
+
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    // Create the context, make it current and load the GL functions. Returns
+    // false (after printing why) if no context of at least GL 3.3 is available.
+    bool create(bool debug = false);
+
+    // How create() got its context, e.g. "EGL surfaceless" or "hidden SDL window"
+    const char* backendName() const { return m_backendName; }
+
+private:
+    bool createEGL(bool debug);
+    bool createSDL(bool debug);
+    void destroy();
+
+    const char* m_backendName = "";
+    // EGL handles (EGLDisplay, EGLContext, EGLSurface), kept opaque so this
+    // header does not pull in the platform's EGL and window system headers
+    void* m_eglDisplay = nullptr;
+    void* m_eglContext = nullptr;
+    void* m_eglSurface = nullptr;
+    SDL_Window* m_window = nullptr;
+    SDL_GLContextState* m_sdlContext = nullptr;
+    bool m_sdlInitialized = false;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+// Sort [data, data + count) using all OpenMP threads: sort equal slices in
+// parallel, then merge neighbouring slices pairwise until one run remains.
+// Falls back to std::sort for small inputs or builds without OpenMP.
+// Like std::sort it is not stable, so give `comp` a total order when the
+// result has to be deterministic.
+template <typename T, typename Compare>
+void parallelSort(T* data, size_t count, Compare comp) {
+#ifdef HAVE_OPENMP
+    const size_t minSlice = 1u << 16;
+    size_t slices = static_cast<size_t>(omp_get_max_threads());
+    slices = std::min(slices, count / minSlice);
+    if (slices < 2) {
+        std::sort(data, data + count, comp);
+        return;
+    }
+
+    std::vector<size_t> bounds(slices + 1);
+    for (size_t i = 0; i <= slices; ++i) {
+        bounds[i] = count * i / slices;
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (long long i = 0; i < static_cast<long long>(slices); ++i) {
+        std::sort(data + bounds[i], data + bounds[i + 1], comp);
+    }
+
+    for (size_t width = 1; width < slices; width *= 2) {
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (long long i = 0; i < static_cast<long long>(slices); i += 2 * static_cast<long long>(width)) {
+            const size_t mid = std::min(static_cast<size_t>(i) + width, slices);
+            const size_t last = std::min(static_cast<size_t>(i) + 2 * width, slices);
+            if (mid < last) {
+                std::inplace_merge(data + bounds[i], data + bounds[mid], data + bounds[last], comp);
+            }
+        }
+    }
+#else
+    std::sort(data, data + count, comp);
+#endif
+}
+
+template <typename T, typename Compare>
+void parallelSort(std::vector<T>& values, Compare comp) {
+    parallelSort(values.data(), values.size(), comp);
+}
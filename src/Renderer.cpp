@@ -1,40 +1,54 @@
 ﻿#include "Renderer.h"
+#include "MeshTriangulator.h"
+#include "EdgeExtractor.h"
+#include "MeshSimplifier.h"
+#include "progress/Progress_abstract.h"  // Include for mySTLviewer standalone compilation
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <limits>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <new>
 #include <glm/gtc/type_ptr.hpp>
-#include <mapbox/earcut.hpp>
-#include <array>
 
 Renderer::Renderer()
         : m_VAO(0), m_VBO(0), m_EBO(0), m_edgeEBO(0),
-            m_shaderProgramSolid(0), m_shaderProgramWireframe(0),
+            m_shaderProgramSolid(0), m_shaderProgramWireframe(0), m_frameUniformBuffer(0),
         m_normalsVAO(0), m_normalsVBO(0), m_shaderProgramNormals(0),
         m_normalsVertexCount(0),
         m_triNormalsVAO(0), m_triNormalsVBO(0), m_triNormalsVertexCount(0),
-        m_triEdgesVAO(0), m_triEdgesVBO(0), m_triEdgesVertexCount(0),
-        m_solidVAO(0), m_solidVBO(0), m_solidVertexCount(0),
+        m_debugGeometryBuilt(false),
+        m_shaderProgramPick(0), m_pickFBO(0), m_pickColorBuffer(0), m_pickDepthBuffer(0), m_pickPBO(0),
+        m_pickFence(nullptr),
+        m_facetDataBuffer(0), m_facetDataTexture(0), m_triangleFacetBuffer(0), m_triangleFacetTexture(0),
+        m_facetLookup(FacetLookup::None),
+        m_quantized(false), m_positionOffset(0.0f), m_positionScale(1.0f),
         m_drawFacetNormals(false), m_normalLengthScale(0.03f), m_cullingEnabled(false),
-            m_drawSolid(true), m_drawWireframe(false), m_indexCount(0), m_edgeIndexCount(0) {
+            m_drawSolid(true), m_drawWireframe(false), m_featureEdgesOnly(false),
+            m_debugValidation(false), m_debugOutput(false),
+            m_viewportSize(1.0f), m_minClusterPixels(1.0f), m_visibleTriangleCount(0),
+            m_solidDrawCount(0),
+            m_lodEBO(0), m_lodLevel(0),
+            m_indexCount(0), m_edgeIndexCount(0), m_featureEdgeIndexCount(0) {
 }
 
 Renderer::~Renderer() {
+    stopLodBuild();
     if (m_VAO) glDeleteVertexArrays(1, &m_VAO);
     if (m_VBO) glDeleteBuffers(1, &m_VBO);
     if (m_EBO) glDeleteBuffers(1, &m_EBO);
     if (m_edgeEBO) glDeleteBuffers(1, &m_edgeEBO);
+    if (m_lodEBO) glDeleteBuffers(1, &m_lodEBO);
     if (m_shaderProgramSolid) glDeleteProgram(m_shaderProgramSolid);
     if (m_shaderProgramWireframe) glDeleteProgram(m_shaderProgramWireframe);
-    if (m_normalsVAO) glDeleteVertexArrays(1, &m_normalsVAO);
-    if (m_normalsVBO) glDeleteBuffers(1, &m_normalsVBO);
     if (m_shaderProgramNormals) glDeleteProgram(m_shaderProgramNormals);
-    if (m_triNormalsVAO) glDeleteVertexArrays(1, &m_triNormalsVAO);
-    if (m_triNormalsVBO) glDeleteBuffers(1, &m_triNormalsVBO);
-    if (m_triEdgesVAO) glDeleteVertexArrays(1, &m_triEdgesVAO);
-    if (m_triEdgesVBO) glDeleteBuffers(1, &m_triEdgesVBO);
-    if (m_solidVAO) glDeleteVertexArrays(1, &m_solidVAO);
-    if (m_solidVBO) glDeleteBuffers(1, &m_solidVBO);
+    if (m_shaderProgramPick) glDeleteProgram(m_shaderProgramPick);
+    if (m_frameUniformBuffer) glDeleteBuffers(1, &m_frameUniformBuffer);
+    deleteDebugGeometry();
+    deletePickTargets();
+    deleteFacetBuffers();
 }
 
 bool Renderer::initialize() {
@@ -42,15 +56,343 @@ bool Renderer::initialize() {
         std::cerr << "Failed to load shaders" << std::endl;
         return false;
     }
+    
+    // One uniform buffer holds the camera and light for every program; the
+    // binding point stays attached for the lifetime of the context
+    glGenBuffers(1, &m_frameUniformBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_frameUniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, kFrameUniformsBinding, m_frameUniformBuffer);
     return true;
 }
 
+void Renderer::bindFrameUniforms(GLuint program) {
+    GLuint blockIndex = glGetUniformBlockIndex(program, "FrameUniforms");
+    if (blockIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, blockIndex, kFrameUniformsBinding);
+    }
+}
+
+void Renderer::updateFrameUniforms(const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model,
+                                   const glm::vec3& lightDirection) {
+    static_assert(sizeof(FrameUniforms) == 320, "FrameUniforms must match the std140 block layout");
+    FrameUniforms frame;
+    frame.projection = projection;
+    frame.view = view;
+    frame.model = model;
+    frame.modelView = view * model;
+    // Facet normals go to view space once per frame instead of once per vertex
+    const glm::mat3 normalMatrix = glm::mat3(view) * glm::transpose(glm::inverse(glm::mat3(model)));
+    for (int c = 0; c < 3; ++c) {
+        frame.normalMatrix[c] = glm::vec4(normalMatrix[c], 0.0f);
+    }
+    frame.lightDirectionVS = glm::vec4(glm::normalize(glm::mat3(view) * lightDirection), 0.0f);
+    
+    // Orphan the previous contents so the driver never waits for last frame's draws
+    glBindBuffer(GL_UNIFORM_BUFFER, m_frameUniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frame);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void Renderer::applyMeshUniforms() {
+    // Uniforms keep their values in the program, so the per-mesh ones are set once per upload
+    glUseProgram(m_shaderProgramSolid);
+    glUniform3fv(m_solidUniforms.positionOffset, 1, glm::value_ptr(m_positionOffset));
+    glUniform3fv(m_solidUniforms.positionScale, 1, glm::value_ptr(m_positionScale));
+    glUniform1i(m_solidUniforms.octahedralNormals, m_quantized ? 1 : 0);
+    glUseProgram(m_shaderProgramWireframe);
+    glUniform3fv(m_wireframeUniforms.positionOffset, 1, glm::value_ptr(m_positionOffset));
+    glUniform3fv(m_wireframeUniforms.positionScale, 1, glm::value_ptr(m_positionScale));
+    glUseProgram(m_shaderProgramPick);
+    glUniform3fv(m_pickUniforms.positionOffset, 1, glm::value_ptr(m_positionOffset));
+    glUniform3fv(m_pickUniforms.positionScale, 1, glm::value_ptr(m_positionScale));
+    glUseProgram(0);
+}
+
 void Renderer::setMesh(std::unique_ptr<Mesh> mesh) {
-    m_mesh = std::move(mesh);
-    setupMesh();
+    setPreparedMesh(prepareMesh(std::move(mesh)));
+}
+
+void Renderer::setPreparedMesh(std::unique_ptr<MeshRenderData> data) {
+    if (!data) {
+        return;
+    }
+    // The level-of-detail worker reads the current mesh, and a pick in
+    // flight would name one of its triangles
+    stopLodBuild();
+    if (m_pickFence) {
+        glDeleteSync(m_pickFence);
+        m_pickFence = nullptr;
+    }
+    m_mesh = std::move(data->mesh);
+    m_bvh = std::move(data->bvh);
+    uploadMesh(*data);
+    if (data->buildLevelsOfDetail && m_mesh && m_mesh->triangleFacets.size() >= kLodMinTriangles) {
+        startLodBuild();
+    }
+}
+
+void Renderer::startLodBuild() {
+    m_lodProgress.reset();
+    m_lodFinished = false;
+    const Mesh* mesh = m_mesh.get();
+    m_lodWorker = std::thread([this, mesh]() {
+        // Stop simplifying once a level is this small; drawing it is cheap anyway
+        const size_t coarsestTriangles = 50000;
+        std::vector<MeshSimplifier::Level> levels;
+        try {
+            levels = MeshSimplifier::buildLevels(*mesh, coarsestTriangles, &m_lodProgress);
+        } catch (const std::bad_alloc&) {
+            std::cerr << "Out of memory while building levels of detail" << std::endl;
+            levels.clear();
+        }
+        m_lodResult = std::move(levels);
+        m_lodFinished.store(true, std::memory_order_release);
+    });
+}
+
+void Renderer::stopLodBuild() {
+    m_lodProgress.cancel();
+    if (m_lodWorker.joinable()) {
+        m_lodWorker.join();
+    }
+    m_lodResult.clear();
+}
+
+bool Renderer::pollLevelsOfDetail() {
+    if (!m_lodWorker.joinable() || !m_lodFinished.load(std::memory_order_acquire)) {
+        return false;
+    }
+    m_lodWorker.join();
+    std::vector<MeshSimplifier::Level> levels = std::move(m_lodResult);
+    m_lodResult.clear();
+    if (levels.empty()) {
+        return false;
+    }
+    
+    // All levels in one index buffer over the shared vertex buffer; bound to
+    // the VAO only when drawn, so upload through a binding point outside it
+    size_t indexCount = 0;
+    for (const MeshSimplifier::Level& level : levels) {
+        indexCount += level.triangleIndices.size();
+    }
+    glGenBuffers(1, &m_lodEBO);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_lodEBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexCount * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+    std::cout << "Levels of detail:";
+    size_t firstIndex = 0;
+    for (const MeshSimplifier::Level& level : levels) {
+        glBufferSubData(GL_COPY_WRITE_BUFFER, firstIndex * sizeof(unsigned int),
+                        level.triangleIndices.size() * sizeof(unsigned int), level.triangleIndices.data());
+        m_lodLevels.push_back({firstIndex, level.triangleIndices.size(), level.error});
+        firstIndex += level.triangleIndices.size();
+        std::cout << " " << level.triangleIndices.size() / 3 << " triangles (error " << level.error << ")";
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    std::cout << ", " << (indexCount * sizeof(unsigned int) + (1 << 19)) / (1 << 20) << " MB of GPU buffers" << std::endl;
+    return true;
+}
+
+size_t Renderer::selectLevelOfDetail(const glm::mat4& mvp) const {
+    if (m_lodLevels.empty()) {
+        return 0;
+    }
+    // Screen pixels per model unit, the largest over all directions; exact for
+    // the viewer's orthographic projection (clip w == 1)
+    const float pixelsPerUnit = 0.5f * std::max(
+        glm::length(glm::vec3(mvp[0][0], mvp[1][0], mvp[2][0])) * m_viewportSize.x,
+        glm::length(glm::vec3(mvp[0][1], mvp[1][1], mvp[2][1])) * m_viewportSize.y);
+    size_t level = 0;
+    for (size_t i = 0; i < m_lodLevels.size(); ++i) {
+        if (m_lodLevels[i].error * pixelsPerUnit <= kLodPixelError) {
+            level = i + 1;
+        }
+    }
+    return level;
+}
+
+namespace {
+    // Facet data built per facet, rearranged so texel pair t belongs to triangle t
+    // (meshes with exactly one triangle per facet)
+    template <typename Texel>
+    void reorderFacetTexels(std::vector<Texel>& texels, const std::vector<unsigned int>& triangleFacets) {
+        std::vector<Texel> reordered(texels.size());
+#ifdef HAVE_OPENMP
+        #pragma omp parallel for schedule(static) if (triangleFacets.size() > 300000)
+#endif
+        for (long long t = 0; t < static_cast<long long>(triangleFacets.size()); ++t) {
+            reordered[2 * t] = texels[2 * size_t(triangleFacets[t])];
+            reordered[2 * t + 1] = texels[2 * size_t(triangleFacets[t]) + 1];
+        }
+        texels.swap(reordered);
+    }
+}
+
+std::unique_ptr<MeshRenderData> Renderer::prepareMesh(std::unique_ptr<Mesh> mesh, const MeshRenderOptions& options,
+                                                      Progress_abstract* progress) {
+    auto data = std::make_unique<MeshRenderData>();
+    data->mesh = std::move(mesh);
+    if (!data->mesh || data->mesh->vertices.empty()) {
+        return data;
+    }
+    Mesh& m = *data->mesh;
+    
+    if (progress) {
+        progress->setMessage("Preparing mesh...");
+        progress->setProgress(0.0f);
+    }
+    
+    // Triangulate on first use; meshes restored from the cache already carry their triangles and edges
+    if (m.triangleIndices.empty() && !m.facets.empty()) {
+        MeshTriangulator::triangulate(m);
+    }
+    if (m.edgeIndices.empty() && !m.facets.empty()) {
+        EdgeExtractor::extract(m);
+    }
+    
+    // All-triangle meshes (STL) usually have triangle i == facet i; then the facet
+    // data can follow the triangle order and no lookup buffer is needed
+    bool perTriangle = m.triangleFacets.size() == m.facets.size();
+    if (perTriangle) {
+        long long mismatches = 0;
+#ifdef HAVE_OPENMP
+        #pragma omp parallel for schedule(static) reduction(+:mismatches) if (m.triangleFacets.size() > 300000)
+#endif
+        for (long long t = 0; t < static_cast<long long>(m.triangleFacets.size()); ++t) {
+            mismatches += (m.triangleFacets[t] != static_cast<unsigned int>(t));
+        }
+        perTriangle = mismatches == 0;
+    }
+    data->facetDataPerTriangle = perTriangle;
+    data->buildLevelsOfDetail = options.levelOfDetail;
+    
+    // Reorders the triangles, so it must come before anything that depends on their order
+    data->clusters = MeshClusters::build(m, progress);
+    if (!data->bvh.build(m, progress)) return nullptr;
+    if (progress) {
+        if (progress->isCancelled()) return nullptr;
+        progress->setProgress(0.5f);
+    }
+    
+    if (!options.quantize || !quantizeMesh(*data, options.quantizeTolerance)) {
+        // Positions only: every pass draws from this one buffer
+        data->positions.resize(m.vertices.size());
+#ifdef HAVE_OPENMP
+        #pragma omp parallel for schedule(static) if (m.vertices.size() > 300000)
+#endif
+        for (long long i = 0; i < static_cast<long long>(m.vertices.size()); ++i) {
+            data->positions[i] = m.vertices[i].position;
+        }
+        
+        // Facet normal and center for every facet that produced triangles
+        data->facetData.assign(m.facets.size() * 2, glm::vec4(0.0f));
+#ifdef HAVE_OPENMP
+        #pragma omp parallel for schedule(static) if (m.facets.size() > 100000)
+#endif
+        for (long long f = 0; f < static_cast<long long>(m.facets.size()); ++f) {
+            const FacetView facet = m.facets[f];
+            if (facet.size() < 3) continue; // Skip degenerate facets
+            data->facetData[2 * f] = glm::vec4(MeshTriangulator::facetNormal(m, facet), 0.0f);
+            data->facetData[2 * f + 1] = glm::vec4(MeshTriangulator::facetCenter(m, facet), 1.0f);
+        }
+    }
+    
+    if (perTriangle) {
+        if (data->isQuantized()) {
+            reorderFacetTexels(data->quantizedFacetData, m.triangleFacets);
+        } else {
+            reorderFacetTexels(data->facetData, m.triangleFacets);
+        }
+    }
+    
+    if (progress) {
+        if (progress->isCancelled()) return nullptr;
+        progress->setMessage("Complete");
+        progress->setProgress(1.0f);
+    }
+    return data;
+}
+
+namespace {
+    constexpr float kQuantizedMax = 65535.0f;
+
+    // Octahedral encoding: project the unit normal onto the octahedron |x|+|y|+|z| = 1,
+    // fold the lower half over the upper one and store x, y as 16-bit unorm.
+    // Decoded by octahedralDecode() in fragment.glsl; the angular error stays
+    // below 0.01 degrees.
+    glm::u16vec2 octahedralEncode(const glm::vec3& n) {
+        float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        if (l1 <= 0.0f) return glm::u16vec2(32768, 32768); // degenerate facet: (0, 0, 1)
+        glm::vec2 p = glm::vec2(n.x, n.y) / l1;
+        if (n.z < 0.0f) {
+            glm::vec2 s(p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f);
+            p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * s;
+        }
+        glm::vec2 unorm = glm::clamp(p * 0.5f + 0.5f, 0.0f, 1.0f);
+        return glm::u16vec2(glm::round(unorm * kQuantizedMax));
+    }
+}
+
+bool Renderer::quantizeMesh(MeshRenderData& data, float tolerance) {
+    const Mesh& m = *data.mesh;
+    if (tolerance < 0.0f) {
+        tolerance = m.getMaxExtent() * 1e-4f;
+    }
+    
+    // 16-bit grid over the bounding box; flat axes collapse to the offset
+    const glm::vec3 offset = m.min_bounds;
+    const glm::vec3 extent = m.max_bounds - m.min_bounds;
+    glm::vec3 toGrid(0.0f);
+    for (int a = 0; a < 3; ++a) {
+        if (extent[a] > 0.0f) toGrid[a] = kQuantizedMax / extent[a];
+    }
+    auto quantize = [&](const glm::vec3& p) {
+        return glm::clamp(glm::round((p - offset) * toGrid), glm::vec3(0.0f), glm::vec3(kQuantizedMax));
+    };
+    
+    // Measure the error against the same reconstruction the vertex shader does,
+    // so the bound covers float rounding in the decode as well
+    data.quantizedPositions.resize(m.vertices.size());
+    float maxError2 = 0.0f;
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(static) reduction(max:maxError2) if (m.vertices.size() > 300000)
+#endif
+    for (long long i = 0; i < static_cast<long long>(m.vertices.size()); ++i) {
+        const glm::vec3& p = m.vertices[i].position;
+        glm::vec3 q = quantize(p);
+        data.quantizedPositions[i] = glm::u16vec4(glm::u16vec3(q), 0);
+        glm::vec3 d = offset + (q / kQuantizedMax) * extent - p;
+        maxError2 = std::max(maxError2, glm::dot(d, d));
+    }
+    float maxError = std::sqrt(maxError2);
+    if (!(maxError <= tolerance)) {
+        std::cout << "Quantization would move vertices by up to " << maxError
+                  << " (tolerance " << tolerance << "); keeping float positions" << std::endl;
+        std::vector<glm::u16vec4>().swap(data.quantizedPositions);
+        return false;
+    }
+    
+    // Facet centers share the position grid; they lie inside the bounding box too
+    data.quantizedFacetData.assign(m.facets.size() * 2, glm::u16vec4(0));
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(static) if (m.facets.size() > 100000)
+#endif
+    for (long long f = 0; f < static_cast<long long>(m.facets.size()); ++f) {
+        const FacetView facet = m.facets[f];
+        if (facet.size() < 3) continue; // Skip degenerate facets
+        data.quantizedFacetData[2 * f] = glm::u16vec4(octahedralEncode(MeshTriangulator::facetNormal(m, facet)), 0, 0);
+        data.quantizedFacetData[2 * f + 1] = glm::u16vec4(glm::u16vec3(quantize(MeshTriangulator::facetCenter(m, facet))), 0);
+    }
+    data.positionOffset = offset;
+    data.positionScale = extent;
+    std::cout << "Quantized positions to 16 bits, max error " << maxError
+              << " (tolerance " << tolerance << ")" << std::endl;
+    return true;
 }
 
-void Renderer::setupMesh() {
+void Renderer::uploadMesh(const MeshRenderData& data) {
     if (!m_mesh || m_mesh->vertices.empty()) {
         return;
     }
@@ -60,14 +402,11 @@ void Renderer::setupMesh() {
     if (m_VBO) glDeleteBuffers(1, &m_VBO);
     if (m_EBO) glDeleteBuffers(1, &m_EBO);
     if (m_edgeEBO) glDeleteBuffers(1, &m_edgeEBO);
-    if (m_normalsVAO) { glDeleteVertexArrays(1, &m_normalsVAO); m_normalsVAO = 0; }
-    if (m_normalsVBO) { glDeleteBuffers(1, &m_normalsVBO); m_normalsVBO = 0; }
-    if (m_triNormalsVAO) { glDeleteVertexArrays(1, &m_triNormalsVAO); m_triNormalsVAO = 0; }
-    if (m_triNormalsVBO) { glDeleteBuffers(1, &m_triNormalsVBO); m_triNormalsVBO = 0; }
-    if (m_triEdgesVAO) { glDeleteVertexArrays(1, &m_triEdgesVAO); m_triEdgesVAO = 0; }
-    if (m_triEdgesVBO) { glDeleteBuffers(1, &m_triEdgesVBO); m_triEdgesVBO = 0; }
-    if (m_solidVAO) { glDeleteVertexArrays(1, &m_solidVAO); m_solidVAO = 0; }
-    if (m_solidVBO) { glDeleteBuffers(1, &m_solidVBO); m_solidVBO = 0; }
+    if (m_lodEBO) { glDeleteBuffers(1, &m_lodEBO); m_lodEBO = 0; }
+    m_lodLevels.clear();
+    m_lodLevel = 0;
+    deleteFacetBuffers();
+    deleteDebugGeometry();
     
     // Generate buffers
     glGenVertexArrays(1, &m_VAO);
@@ -77,104 +416,19 @@ void Renderer::setupMesh() {
     
     glBindVertexArray(m_VAO);
     
-    // Upload vertex data
+    // Upload vertex positions
+    m_quantized = data.isQuantized();
+    m_positionOffset = data.positionOffset;
+    m_positionScale = data.positionScale;
+    const size_t positionBytes = m_quantized ? data.quantizedPositions.size() * sizeof(glm::u16vec4)
+                                             : data.positions.size() * sizeof(glm::vec3);
     glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-    glBufferData(GL_ARRAY_BUFFER, m_mesh->vertices.size() * sizeof(Vertex),
-                 m_mesh->vertices.data(), GL_STATIC_DRAW);
-    
-    // Convert facets to triangle indices using earcut for proper triangulation
-    std::vector<unsigned int> triangleIndices;
-    struct SolidVertex { glm::vec3 position; glm::vec3 facetNormal; glm::vec3 facetCenter; };
-    std::vector<SolidVertex> solidVertices;
-
-    for (const auto& facet : m_mesh->facets) {
-        const size_t n = facet.indices.size();
-        if (n < 3) continue; // Skip degenerate facets
-
-        // Compute facet centroid
-        glm::vec3 facetCenter(0.0f);
-        for (unsigned int idx : facet.indices) {
-            facetCenter += m_mesh->vertices[idx].position;
-        }
-        facetCenter /= static_cast<float>(n);
-
-        // Compute a robust facet normal via Newell's method
-        glm::vec3 facetNormal(0.0f);
-        for (size_t i = 0; i < n; ++i) {
-            const glm::vec3& v1 = m_mesh->vertices[facet.indices[i]].position;
-            const glm::vec3& v2 = m_mesh->vertices[facet.indices[(i + 1) % n]].position;
-            facetNormal.x += (v1.y - v2.y) * (v1.z + v2.z);
-            facetNormal.y += (v1.z - v2.z) * (v1.x + v2.x);
-            facetNormal.z += (v1.x - v2.x) * (v1.y + v2.y);
-        }
-        if (glm::length(facetNormal) < 1e-8f) {
-            // Fallback to first triangle cross if Newell's degenerate
-            const glm::vec3 a = m_mesh->vertices[facet.indices[0]].position;
-            const glm::vec3 b = m_mesh->vertices[facet.indices[1]].position;
-            const glm::vec3 c = m_mesh->vertices[facet.indices[2]].position;
-            facetNormal = glm::cross(b - a, c - a);
-        }
-        if (glm::length(facetNormal) > 1e-8f) {
-            facetNormal = glm::normalize(facetNormal);
-        }
-
-        auto appendOrientedTri = [&](unsigned int i0, unsigned int i1, unsigned int i2) {
-            triangleIndices.push_back(i0);
-            triangleIndices.push_back(i1);
-            triangleIndices.push_back(i2);
-            // Push de-indexed solid vertices with facet normal AND facet center
-            solidVertices.push_back({ m_mesh->vertices[i0].position, facetNormal, facetCenter });
-            solidVertices.push_back({ m_mesh->vertices[i1].position, facetNormal, facetCenter });
-            solidVertices.push_back({ m_mesh->vertices[i2].position, facetNormal, facetCenter });
-        };
-
-        if (n == 3) {
-            appendOrientedTri(facet.indices[0], facet.indices[1], facet.indices[2]);
-        } else {
-            // For polygons with more than 3 vertices, triangulate by projecting onto the facet plane
-            using Point = std::array<double, 2>;
-            std::vector<std::vector<Point>> polygon;
-            std::vector<Point> ring;
-            ring.reserve(n);
-
-            // Build a local 2D basis on the facet plane
-            // Choose an up vector not parallel to facetNormal
-            glm::vec3 up = (std::abs(facetNormal.z) < 0.9f) ? glm::vec3(0,0,1) : glm::vec3(0,1,0);
-            glm::vec3 tangent = glm::normalize(glm::cross(up, facetNormal));
-            glm::vec3 bitangent = glm::normalize(glm::cross(facetNormal, tangent));
-            // Use centroid as origin for numerical stability
-            glm::vec3 centroid(0.0f);
-            for (unsigned int idx : facet.indices) centroid += m_mesh->vertices[idx].position;
-            centroid /= static_cast<float>(n);
-            for (unsigned int idx : facet.indices) {
-                glm::vec3 p = m_mesh->vertices[idx].position - centroid;
-                double u = static_cast<double>(glm::dot(p, tangent));
-                double v = static_cast<double>(glm::dot(p, bitangent));
-                ring.push_back(Point{u, v});
-            }
-            polygon.push_back(ring);
-
-            std::vector<unsigned int> localIndices = mapbox::earcut<unsigned int>(polygon);
-
-            if (localIndices.size() < (n - 2) * 3) {
-                // Fallback: simple triangle fan around vertex 0
-                for (size_t j = 1; j + 1 < n; ++j) {
-                    unsigned int gi0 = facet.indices[0];
-                    unsigned int gi1 = facet.indices[j];
-                    unsigned int gi2 = facet.indices[j + 1];
-                    appendOrientedTri(gi0, gi1, gi2);
-                }
-            } else {
-                // Map local earcut indices back to the facet's global vertex indices
-                for (size_t k = 0; k + 2 < localIndices.size(); k += 3) {
-                    unsigned int gi0 = facet.indices[localIndices[k + 0]];
-                    unsigned int gi1 = facet.indices[localIndices[k + 1]];
-                    unsigned int gi2 = facet.indices[localIndices[k + 2]];
-                    appendOrientedTri(gi0, gi1, gi2);
-                }
-            }
-        }
-    }
+    glBufferData(GL_ARRAY_BUFFER, positionBytes,
+                 m_quantized ? static_cast<const void*>(data.quantizedPositions.data())
+                             : static_cast<const void*>(data.positions.data()),
+                 GL_STATIC_DRAW);
+    
+    const std::vector<unsigned int>& triangleIndices = m_mesh->triangleIndices;
     
     // Store the number of indices for rendering
     m_indexCount = triangleIndices.size();
@@ -184,21 +438,11 @@ void Renderer::setupMesh() {
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, triangleIndices.size() * sizeof(unsigned int),
                  triangleIndices.data(), GL_STATIC_DRAW);
     
-    // Build edge indices for wireframe (original facet edges only, no triangulation)
-    std::vector<unsigned int> edgeIndices;
-    for (const auto& facet : m_mesh->facets) {
-        if (facet.indices.size() < 2) {
-            continue; // Skip degenerate facets
-        }
-        
-        // Create edges around the perimeter of the facet
-        for (size_t i = 0; i < facet.indices.size(); ++i) {
-            edgeIndices.push_back(facet.indices[i]);
-            edgeIndices.push_back(facet.indices[(i + 1) % facet.indices.size()]);
-        }
-    }
+    // Edge indices for wireframe (unique facet edges, no triangulation), smooth edges last
+    const std::vector<unsigned int>& edgeIndices = m_mesh->edgeIndices;
     
     m_edgeIndexCount = edgeIndices.size();
+    m_featureEdgeIndexCount = std::min<size_t>(m_edgeIndexCount, size_t(2) * m_mesh->edgeClassOffsets[Mesh::SmoothEdge]);
     
     // Upload edge index data to separate buffer
     if (m_edgeEBO == 0) {
@@ -229,16 +473,15 @@ void Renderer::setupMesh() {
     // Bind back to triangle EBO as default
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
     
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                         (void*)offsetof(Vertex, position));
+    // Position attribute; quantized positions arrive normalized to [0, 1] and
+    // the shaders rescale them with positionOffset / positionScale
+    if (m_quantized) {
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(glm::u16vec4), (void*)0);
+    } else {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    }
     glEnableVertexAttribArray(0);
     
-    // Normal attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
-                         (void*)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(1);
-    
     glBindVertexArray(0);
     
     // Verify VAO was created successfully
@@ -253,101 +496,155 @@ void Renderer::setupMesh() {
         std::cerr << "OpenGL error after mesh setup: 0x" << std::hex << setupErr << std::dec << std::endl;
     }
     
+    uploadFacetBuffers(data);
+    applyMeshUniforms();
+    m_clusters = data.clusters;
+    
+    size_t gpuBytes = positionBytes + (m_indexCount + m_edgeIndexCount) * sizeof(unsigned int);
+    if (m_facetLookup != FacetLookup::None) {
+        gpuBytes += m_quantized ? data.quantizedFacetData.size() * sizeof(glm::u16vec4)
+                                : data.facetData.size() * sizeof(glm::vec4);
+        if (m_facetLookup == FacetLookup::TriangleFacets) {
+            gpuBytes += m_mesh->triangleFacets.size() * sizeof(unsigned int);
+        }
+    }
     std::cout << "Mesh setup complete: " << m_mesh->vertices.size() 
               << " vertices, " << m_mesh->facets.size() << " facets, " 
-              << m_indexCount / 3 << " triangles" << std::endl;
-
-    // Build facet normals debug geometry
-    setupFacetNormals();
+              << m_indexCount / 3 << " triangles in " << m_clusters.clusterCount() << " clusters, "
+              << (gpuBytes + (1 << 19)) / (1 << 20) << " MB of GPU buffers"
+              << (m_quantized ? " (quantized)" : "") << std::endl;
+}
 
-    // Build triangle normals debug geometry (from triangulated indices)
-    m_triNormalsVertexCount = 0;
-    m_triEdgesVertexCount = 0;
-    if (!triangleIndices.empty()) {
-        float length = glm::max(0.001f, m_mesh->getMaxExtent() * m_normalLengthScale);
-        std::vector<glm::vec3> triLineVerts;
-        std::vector<glm::vec3> triEdgeVerts;
-        triLineVerts.reserve((triangleIndices.size() / 3) * 2);
-        triEdgeVerts.reserve((triangleIndices.size() / 3) * 6);
-        for (size_t i = 0; i + 2 < triangleIndices.size(); i += 3) {
-            unsigned int i0 = triangleIndices[i + 0];
-            unsigned int i1 = triangleIndices[i + 1];
-            unsigned int i2 = triangleIndices[i + 2];
-            const glm::vec3& p0 = m_mesh->vertices[i0].position;
-            const glm::vec3& p1 = m_mesh->vertices[i1].position;
-            const glm::vec3& p2 = m_mesh->vertices[i2].position;
-            glm::vec3 triN = glm::cross(p1 - p0, p2 - p0);
-            float ln = glm::length(triN);
-            if (ln > 1e-12f) triN /= ln; else continue;
-            glm::vec3 centroid = (p0 + p1 + p2) / 3.0f;
-            triLineVerts.push_back(centroid);
-            triLineVerts.push_back(centroid + triN * length);
-            // Triangle edges (3 segments)
-            triEdgeVerts.push_back(p0); triEdgeVerts.push_back(p1);
-            triEdgeVerts.push_back(p1); triEdgeVerts.push_back(p2);
-            triEdgeVerts.push_back(p2); triEdgeVerts.push_back(p0);
-        }
-        if (!triLineVerts.empty()) {
-            glGenVertexArrays(1, &m_triNormalsVAO);
-            glGenBuffers(1, &m_triNormalsVBO);
-            glBindVertexArray(m_triNormalsVAO);
-            glBindBuffer(GL_ARRAY_BUFFER, m_triNormalsVBO);
-            glBufferData(GL_ARRAY_BUFFER, triLineVerts.size() * sizeof(glm::vec3), triLineVerts.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-            glEnableVertexAttribArray(0);
-            glBindVertexArray(0);
-            m_triNormalsVertexCount = static_cast<GLsizei>(triLineVerts.size());
-        }
-        if (!triEdgeVerts.empty()) {
-            glGenVertexArrays(1, &m_triEdgesVAO);
-            glGenBuffers(1, &m_triEdgesVBO);
-            glBindVertexArray(m_triEdgesVAO);
-            glBindBuffer(GL_ARRAY_BUFFER, m_triEdgesVBO);
-            glBufferData(GL_ARRAY_BUFFER, triEdgeVerts.size() * sizeof(glm::vec3), triEdgeVerts.data(), GL_STATIC_DRAW);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-            glEnableVertexAttribArray(0);
-            glBindVertexArray(0);
-            m_triEdgesVertexCount = static_cast<GLsizei>(triEdgeVerts.size());
-        }
+void Renderer::uploadFacetBuffers(const MeshRenderData& data) {
+    // The solid shader reads facet normal and center from texture buffers,
+    // indexed by gl_PrimitiveID (optionally through the triangle -> facet map)
+    m_facetLookup = FacetLookup::None;
+    const size_t facetTexels = m_quantized ? data.quantizedFacetData.size() : data.facetData.size();
+    if (facetTexels == 0 || m_mesh->triangleFacets.empty()) {
+        return;
+    }
+    GLint maxTexels = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    const bool perTriangle = data.facetDataPerTriangle;
+    if (facetTexels > static_cast<size_t>(maxTexels) ||
+        (!perTriangle && m_mesh->triangleFacets.size() > static_cast<size_t>(maxTexels))) {
+        std::cerr << "Warning: mesh exceeds the texture buffer limit (" << maxTexels
+                  << " texels); shading per triangle instead of per facet" << std::endl;
+        return;
+    }
+    
+    glGenBuffers(1, &m_facetDataBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, m_facetDataBuffer);
+    if (m_quantized) {
+        glBufferData(GL_TEXTURE_BUFFER, facetTexels * sizeof(glm::u16vec4), data.quantizedFacetData.data(), GL_STATIC_DRAW);
+    } else {
+        glBufferData(GL_TEXTURE_BUFFER, facetTexels * sizeof(glm::vec4), data.facetData.data(), GL_STATIC_DRAW);
+    }
+    glGenTextures(1, &m_facetDataTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, m_facetDataTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, m_quantized ? GL_RGBA16 : GL_RGBA32F, m_facetDataBuffer);
+    
+    if (!perTriangle) {
+        glGenBuffers(1, &m_triangleFacetBuffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, m_triangleFacetBuffer);
+        glBufferData(GL_TEXTURE_BUFFER, m_mesh->triangleFacets.size() * sizeof(unsigned int),
+                     m_mesh->triangleFacets.data(), GL_STATIC_DRAW);
+        glGenTextures(1, &m_triangleFacetTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, m_triangleFacetTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_triangleFacetBuffer);
     }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    m_facetLookup = perTriangle ? FacetLookup::PrimitiveId : FacetLookup::TriangleFacets;
+}
 
-    // Build solid-mode VBO/VAO (positions + facet normals + facet centers), draw with glDrawArrays
-    m_solidVertexCount = static_cast<GLsizei>(solidVertices.size());
-    if (m_solidVertexCount > 0) {
-        glGenVertexArrays(1, &m_solidVAO);
-        glGenBuffers(1, &m_solidVBO);
-        glBindVertexArray(m_solidVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, m_solidVBO);
-        glBufferData(GL_ARRAY_BUFFER, solidVertices.size() * sizeof(SolidVertex), solidVertices.data(), GL_STATIC_DRAW);
-        // position at location 0
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SolidVertex), (void*)offsetof(SolidVertex, position));
+void Renderer::deleteFacetBuffers() {
+    if (m_facetDataTexture) { glDeleteTextures(1, &m_facetDataTexture); m_facetDataTexture = 0; }
+    if (m_facetDataBuffer) { glDeleteBuffers(1, &m_facetDataBuffer); m_facetDataBuffer = 0; }
+    if (m_triangleFacetTexture) { glDeleteTextures(1, &m_triangleFacetTexture); m_triangleFacetTexture = 0; }
+    if (m_triangleFacetBuffer) { glDeleteBuffers(1, &m_triangleFacetBuffer); m_triangleFacetBuffer = 0; }
+    m_facetLookup = FacetLookup::None;
+}
+
+void Renderer::buildDebugGeometry() {
+    deleteDebugGeometry();
+    m_debugGeometryBuilt = true;
+    if (!m_mesh || m_mesh->facets.empty()) return;
+    const Mesh& mesh = *m_mesh;
+    const std::vector<unsigned int>& triangleIndices = mesh.triangleIndices;
+    
+    // Compute scale from mesh extent
+    float length = glm::max(0.001f, mesh.getMaxExtent() * m_normalLengthScale);
+    
+    // Facet normals: one segment from each facet centroid
+    std::vector<glm::vec3> lineVerts;
+    lineVerts.reserve(mesh.facets.size() * 2);
+    for (const FacetView facet : mesh.facets) {
+        if (facet.size() < 3) continue;
+        glm::vec3 centroid = MeshTriangulator::facetCenter(mesh, facet);
+        lineVerts.push_back(centroid);
+        lineVerts.push_back(centroid + MeshTriangulator::facetNormal(mesh, facet) * length);
+    }
+    
+    // Triangle normals (from triangulated indices); the triangle edges are drawn
+    // straight from the triangle index buffer
+    std::vector<glm::vec3> triLineVerts;
+    triLineVerts.reserve((triangleIndices.size() / 3) * 2);
+    for (size_t i = 0; i + 2 < triangleIndices.size(); i += 3) {
+        const glm::vec3& p0 = mesh.vertices[triangleIndices[i + 0]].position;
+        const glm::vec3& p1 = mesh.vertices[triangleIndices[i + 1]].position;
+        const glm::vec3& p2 = mesh.vertices[triangleIndices[i + 2]].position;
+        glm::vec3 triN = glm::cross(p1 - p0, p2 - p0);
+        float ln = glm::length(triN);
+        if (ln > 1e-12f) triN /= ln; else continue;
+        glm::vec3 centroid = (p0 + p1 + p2) / 3.0f;
+        triLineVerts.push_back(centroid);
+        triLineVerts.push_back(centroid + triN * length);
+    }
+    
+    auto uploadLines = [](const std::vector<glm::vec3>& verts, GLuint& vao, GLuint& vbo) {
+        if (verts.empty()) return GLsizei(0);
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, verts.size() * sizeof(glm::vec3), verts.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
         glEnableVertexAttribArray(0);
-        // facet normal at location 1
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(SolidVertex), (void*)offsetof(SolidVertex, facetNormal));
-        glEnableVertexAttribArray(1);
-        // facet center at location 2
-        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(SolidVertex), (void*)offsetof(SolidVertex, facetCenter));
-        glEnableVertexAttribArray(2);
         glBindVertexArray(0);
-    }
+        return static_cast<GLsizei>(verts.size());
+    };
+    m_normalsVertexCount = uploadLines(lineVerts, m_normalsVAO, m_normalsVBO);
+    m_triNormalsVertexCount = uploadLines(triLineVerts, m_triNormalsVAO, m_triNormalsVBO);
+}
+
+void Renderer::deleteDebugGeometry() {
+    if (m_normalsVAO) { glDeleteVertexArrays(1, &m_normalsVAO); m_normalsVAO = 0; }
+    if (m_normalsVBO) { glDeleteBuffers(1, &m_normalsVBO); m_normalsVBO = 0; }
+    if (m_triNormalsVAO) { glDeleteVertexArrays(1, &m_triNormalsVAO); m_triNormalsVAO = 0; }
+    if (m_triNormalsVBO) { glDeleteBuffers(1, &m_triNormalsVBO); m_triNormalsVBO = 0; }
+    m_normalsVertexCount = 0;
+    m_triNormalsVertexCount = 0;
+    m_debugGeometryBuilt = false;
 }
 
 void Renderer::render(const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model, const glm::vec3& lightDirection) {
+    // Also used by overlays drawn after the mesh (e.g. the pivot axes)
+    updateFrameUniforms(projection, view, model, lightDirection);
     if (!m_mesh || m_mesh->vertices.empty()) {
         return;
     }
+    pollLevelsOfDetail();
+    const glm::mat4 mvp = projection * view * model;
 
     // Pass 1: Solid fill (if enabled)
     if (m_drawSolid && m_shaderProgramSolid) {
         glUseProgram(m_shaderProgramSolid);
-        GLint projLoc = glGetUniformLocation(m_shaderProgramSolid, "projection");
-        GLint viewLoc = glGetUniformLocation(m_shaderProgramSolid, "view");
-        GLint modelLoc = glGetUniformLocation(m_shaderProgramSolid, "model");
-        GLint lightDirLoc = glGetUniformLocation(m_shaderProgramSolid, "lightDirection");
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        glUniform3fv(lightDirLoc, 1, glm::value_ptr(lightDirection));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_BUFFER, m_facetDataTexture);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_BUFFER, m_triangleFacetTexture);
+        glActiveTexture(GL_TEXTURE0);
 
         glDisable(GL_LINE_SMOOTH);
         glDisable(GL_BLEND);
@@ -358,243 +655,391 @@ void Renderer::render(const glm::mat4& projection, const glm::mat4& view, const
             glDisable(GL_CULL_FACE);
         }
 
-        if (m_solidVAO && m_solidVertexCount > 0) {
-            glBindVertexArray(m_solidVAO);
-            glDrawArrays(GL_TRIANGLES, 0, m_solidVertexCount);
-            glBindVertexArray(0);
+        glBindVertexArray(m_VAO);
+        m_lodLevel = selectLevelOfDetail(mvp);
+        if (m_lodLevel > 0) {
+            // Simplified triangles match no facet; the shader falls back to their own normals
+            const LodLevel& level = m_lodLevels[m_lodLevel - 1];
+            glUniform1i(m_solidUniforms.facetLookup, static_cast<GLint>(FacetLookup::None));
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_lodEBO);
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(level.indexCount), GL_UNSIGNED_INT,
+                           reinterpret_cast<const void*>(level.firstIndex * sizeof(unsigned int)));
+            m_visibleTriangleCount = level.indexCount / 3;
+            m_solidDrawCount = 1;
         } else {
-            glBindVertexArray(m_VAO);
+            glUniform1i(m_solidUniforms.facetLookup, static_cast<GLint>(m_facetLookup));
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-            glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, 0);
-            glBindVertexArray(0);
+            if (m_clusters.empty()) {
+                glUniform1i(m_solidUniforms.primitiveBase, 0);
+                glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indexCount), GL_UNSIGNED_INT, 0);
+                m_visibleTriangleCount = m_indexCount / 3;
+                m_solidDrawCount = 1;
+            } else {
+                // Only the clusters in view. gl_PrimitiveID restarts at 0 in every
+                // draw, so each range passes its first triangle for the facet lookup
+                // (GL 3.3 has no gl_DrawID, which rules out one glMultiDrawElements).
+                // cull() bridges small gaps, which keeps the number of draws low
+                m_clusters.cull(mvp, m_viewportSize, m_minClusterPixels, m_visibleRanges);
+                m_visibleTriangleCount = 0;
+                m_solidDrawCount = m_visibleRanges.size();
+                for (const MeshClusters::Range& range : m_visibleRanges) {
+                    glUniform1i(m_solidUniforms.primitiveBase, static_cast<GLint>(range.firstTriangle));
+                    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(range.triangleCount * 3), GL_UNSIGNED_INT,
+                                   reinterpret_cast<const void*>(size_t(range.firstTriangle) * 3 * sizeof(unsigned int)));
+                    m_visibleTriangleCount += range.triangleCount;
+                }
+            }
         }
+        glBindVertexArray(0);
+        checkGLError("solid pass");
     }
 
-    // Pass 2: Wireframe overlay (if enabled)
-    if (m_drawWireframe && m_shaderProgramWireframe) {
-        // Validate buffers and counts before rendering
-        if (m_edgeEBO == 0) {
-            std::cerr << "ERROR: Wireframe EBO is 0 (not initialized)" << std::endl;
-            GLenum err = glGetError();
-            if (err != GL_NO_ERROR) {
-                std::cerr << "  OpenGL error before check: 0x" << std::hex << err << std::dec << std::endl;
-            }
-            return;
-        }
-        
-        if (m_edgeIndexCount == 0) {
-            std::cerr << "ERROR: Wireframe edge index count is 0" << std::endl;
-            return;
-        }
-        
-        if (m_VAO == 0) {
-            std::cerr << "ERROR: VAO is 0 (not initialized)" << std::endl;
-            return;
-        }
-        
+    // Pass 2: Wireframe overlay (if enabled). No state queries here: they stall
+    // the driver every frame, so they only run with debug validation on. A
+    // failed validation skips this pass only
+    if (m_drawWireframe && m_shaderProgramWireframe && m_edgeIndexCount > 0 &&
+        (!m_debugValidation || validateWireframeState())) {
+        const UniformLocations& u = m_wireframeUniforms;
         glUseProgram(m_shaderProgramWireframe);
-        GLenum err = glGetError();
-        if (err != GL_NO_ERROR) {
-            std::cerr << "OpenGL error after glUseProgram: 0x" << std::hex << err << std::dec << std::endl;
-        }
-        
-        GLint projLoc = glGetUniformLocation(m_shaderProgramWireframe, "projection");
-        GLint viewLoc = glGetUniformLocation(m_shaderProgramWireframe, "view");
-        GLint modelLoc = glGetUniformLocation(m_shaderProgramWireframe, "model");
-        GLint colorLoc = glGetUniformLocation(m_shaderProgramWireframe, "lineColor");
-        
-        if (projLoc == -1 || viewLoc == -1 || modelLoc == -1 || colorLoc == -1) {
-            std::cerr << "ERROR: Failed to get uniform locations in wireframe shader" << std::endl;
-            std::cerr << "  projLoc=" << projLoc << ", viewLoc=" << viewLoc 
-                      << ", modelLoc=" << modelLoc << ", colorLoc=" << colorLoc << std::endl;
-        }
-        
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-        err = glGetError();
-        if (err != GL_NO_ERROR) {
-            std::cerr << "OpenGL error after glUniformMatrix4fv(projection): 0x" << std::hex << err << std::dec << std::endl;
-        }
-        
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        err = glGetError();
-        if (err != GL_NO_ERROR) {
-            std::cerr << "OpenGL error after glUniformMatrix4fv(view): 0x" << std::hex << err << std::dec << std::endl;
-        }
-        
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        err = glGetError();
-        if (err != GL_NO_ERROR) {
-            std::cerr << "OpenGL error after glUniformMatrix4fv(model): 0x" << std::hex << err << std::dec << std::endl;
-        }
-        
         // White when wireframe-only, black when overlaid on solid
         if (m_drawSolid) {
-            glUniform3f(colorLoc, 0.0f, 0.0f, 0.0f); // black overlay
+            glUniform3f(u.color, 0.0f, 0.0f, 0.0f); // black overlay
         } else {
-            glUniform3f(colorLoc, 1.0f, 1.0f, 1.0f); // white wireframe
-        }
-        err = glGetError();
-        if (err != GL_NO_ERROR) {
-            std::cerr << "OpenGL error after glUniform3f(colorLoc): 0x" << std::hex << err << std::dec << std::endl;
+            glUniform3f(u.color, 1.0f, 1.0f, 1.0f); // white wireframe
         }
 
         glLineWidth(1.5f);
         glDisable(GL_CULL_FACE);
         
-        // Check if VAO is valid before binding
-        if (m_VAO == 0) {
-            std::cerr << "ERROR: Cannot bind VAO - m_VAO is 0" << std::endl;
-            return;
-        }
-        
-        // Clear any pending OpenGL errors before binding
-        while (glGetError() != GL_NO_ERROR) {
-            // Clear all pending errors
-        }
-        
-        // Verify VAO exists before binding
-        GLboolean isVAO = glIsVertexArray(m_VAO);
-        if (!isVAO) {
-            std::cerr << std::endl << "=== WIREFRAME RENDERING ERROR ===" << std::endl;
-            std::cerr << "ERROR: m_VAO=" << m_VAO << " is not a valid vertex array object!" << std::endl;
-            std::cerr << "  This could mean the VAO was deleted or created in a different context" << std::endl;
-            std::cerr << "  m_VBO=" << m_VBO << ", m_EBO=" << m_EBO << ", m_edgeEBO=" << m_edgeEBO << std::endl;
-            std::cerr << "  m_indexCount=" << m_indexCount << ", m_edgeIndexCount=" << m_edgeIndexCount << std::endl;
-            std::cerr << "========================================" << std::endl << std::endl;
-            return;
-        }
-        
-        // Verify VAO exists (check if it's a valid name)
-        GLint currentVAO = 0;
-        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &currentVAO);
-        
+        // Non-smooth edges lead the buffer, so feature-only mode draws a prefix
+        // (which is empty for a closed smooth mesh)
+        const size_t drawCount = m_featureEdgesOnly ? m_featureEdgeIndexCount : m_edgeIndexCount;
         glBindVertexArray(m_VAO);
-        err = glGetError();
-        if (err != GL_NO_ERROR) {
-            std::cerr << "OpenGL error after glBindVertexArray(m_VAO=" << m_VAO << "): 0x" 
-                      << std::hex << err << std::dec << std::endl;
-            if (err == 0x501) { // GL_INVALID_VALUE
-                std::cerr << "  GL_INVALID_VALUE: VAO handle is invalid or was deleted" << std::endl;
-                std::cerr << "  Previous VAO binding was: " << currentVAO << std::endl;
-                // Verify VAO again after failed bind
-                isVAO = glIsVertexArray(m_VAO);
-                std::cerr << "  glIsVertexArray(m_VAO) after failed bind returns: " 
-                          << (isVAO ? "GL_TRUE" : "GL_FALSE") << std::endl;
-            }
-            return;
-        }
-        
-        // Verify VAO was actually bound
-        GLint newVAO = 0;
-        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &newVAO);
-        if (newVAO != static_cast<GLint>(m_VAO)) {
-            std::cerr << "WARNING: VAO binding failed - expected " << m_VAO 
-                      << " but got " << newVAO << std::endl;
-        }
-        
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_edgeEBO);
-        err = glGetError();
-        if (err != GL_NO_ERROR) {
-            std::cerr << "OpenGL error after glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_edgeEBO=" 
-                      << m_edgeEBO << "): 0x" << std::hex << err << std::dec << std::endl;
-        }
-        
-        // Validate buffer before drawing
-        GLint bufferBinding = 0;
-        glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &bufferBinding);
-        if (bufferBinding == 0) {
-            std::cerr << "ERROR: ELEMENT_ARRAY_BUFFER is not bound (binding=0)" << std::endl;
-            glBindVertexArray(0);
-            return;
-        }
-        
-        if (bufferBinding != static_cast<GLint>(m_edgeEBO)) {
-            std::cerr << "WARNING: ELEMENT_ARRAY_BUFFER binding mismatch: expected=" 
-                      << m_edgeEBO << ", actual=" << bufferBinding << std::endl;
-        }
-        
-        // Verify buffer size matches expected count
-        GLint bufferSize = 0;
-        glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &bufferSize);
-        size_t expectedSize = m_edgeIndexCount * sizeof(unsigned int);
-        if (bufferSize != static_cast<GLint>(expectedSize) && m_edgeIndexCount > 0) {
-            std::cerr << "WARNING: Buffer size mismatch: expected=" << expectedSize 
-                      << " bytes, actual=" << bufferSize << " bytes" << std::endl;
-        }
-        
-        if (m_edgeIndexCount > 0) {
-            // Check if count is valid (must be positive and even for GL_LINES)
-            if (m_edgeIndexCount % 2 != 0) {
-                std::cerr << "ERROR: edgeIndexCount is not even (" << m_edgeIndexCount 
-                          << "), cannot draw GL_LINES" << std::endl;
-            } else {
-                // Check for potential overflow (GLsizei max value)
-                const GLsizei maxCount = std::numeric_limits<GLsizei>::max();
-                if (m_edgeIndexCount > static_cast<size_t>(maxCount)) {
-                    std::cerr << "ERROR: edgeIndexCount (" << m_edgeIndexCount 
-                              << ") exceeds GLsizei max (" << maxCount << ")" << std::endl;
-                } else {
-                    glDrawElements(GL_LINES, static_cast<GLsizei>(m_edgeIndexCount), GL_UNSIGNED_INT, 0);
-                    err = glGetError();
-                    if (err != GL_NO_ERROR) {
-                        std::cerr << "OpenGL error after glDrawElements(GL_LINES, count=" 
-                                  << m_edgeIndexCount << "): 0x" << std::hex << err << std::dec << std::endl;
-                        std::cerr << "  VAO=" << m_VAO << ", edgeEBO=" << m_edgeEBO 
-                                  << ", edgeIndexCount=" << m_edgeIndexCount 
-                                  << ", bufferBinding=" << bufferBinding << std::endl;
-                        // Try to decode the error
-                        if (err == GL_INVALID_VALUE) {
-                            std::cerr << "  GL_INVALID_VALUE: count parameter is invalid" << std::endl;
-                        } else if (err == GL_INVALID_OPERATION) {
-                            std::cerr << "  GL_INVALID_OPERATION: invalid operation" << std::endl;
-                        }
-                    }
-                }
-            }
-        } else {
-            std::cerr << "ERROR: Attempting to draw with edgeIndexCount=0" << std::endl;
-        }
-        
+        glDrawElements(GL_LINES, static_cast<GLsizei>(drawCount), GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
+        checkGLError("wireframe pass");
     }
 
     // Optional: draw normals for debugging
     if (m_drawFacetNormals && m_shaderProgramNormals) {
-        GLboolean wasDepth = glIsEnabled(GL_DEPTH_TEST);
-        // Draw on top so you can always see them
+        // Built on first use; most sessions never enable the overlays
+        if (!m_debugGeometryBuilt) {
+            buildDebugGeometry();
+        }
+        // Draw on top so you can always see them (depth testing is always on in this viewer)
         glDisable(GL_DEPTH_TEST);
+        const UniformLocations& u = m_normalsUniforms;
         glUseProgram(m_shaderProgramNormals);
-        GLint projLoc = glGetUniformLocation(m_shaderProgramNormals, "projection");
-        GLint viewLoc = glGetUniformLocation(m_shaderProgramNormals, "view");
-        GLint modelLoc = glGetUniformLocation(m_shaderProgramNormals, "model");
-        GLint colorLoc = glGetUniformLocation(m_shaderProgramNormals, "color");
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+        // Normal lines are always float; only the mesh buffer may be quantized
+        glUniform3f(u.positionOffset, 0.0f, 0.0f, 0.0f);
+        glUniform3f(u.positionScale, 1.0f, 1.0f, 1.0f);
         glLineWidth(1.5f);
         // Facet normals: magenta
         if (m_normalsVAO && m_normalsVertexCount > 0) {
-            glUniform3f(colorLoc, 1.0f, 0.0f, 1.0f);
+            glUniform3f(u.color, 1.0f, 0.0f, 1.0f);
             glBindVertexArray(m_normalsVAO);
             glDrawArrays(GL_LINES, 0, m_normalsVertexCount);
             glBindVertexArray(0);
         }
         // Triangle normals: cyan
         if (m_triNormalsVAO && m_triNormalsVertexCount > 0) {
-            glUniform3f(colorLoc, 0.0f, 1.0f, 1.0f);
+            glUniform3f(u.color, 0.0f, 1.0f, 1.0f);
             glBindVertexArray(m_triNormalsVAO);
             glDrawArrays(GL_LINES, 0, m_triNormalsVertexCount);
             glBindVertexArray(0);
         }
         // Triangle edges: yellow
-        if (m_triEdgesVAO && m_triEdgesVertexCount > 0) {
-            glUniform3f(colorLoc, 1.0f, 1.0f, 0.0f);
-            glBindVertexArray(m_triEdgesVAO);
-            glDrawArrays(GL_LINES, 0, m_triEdgesVertexCount);
+        if (m_VAO && m_indexCount > 0) {
+            glUniform3f(u.color, 1.0f, 1.0f, 0.0f);
+            glUniform3fv(u.positionOffset, 1, glm::value_ptr(m_positionOffset));
+            glUniform3fv(u.positionScale, 1, glm::value_ptr(m_positionScale));
+            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+            glDisable(GL_CULL_FACE);
+            glBindVertexArray(m_VAO);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indexCount), GL_UNSIGNED_INT, 0);
             glBindVertexArray(0);
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
         }
-        if (wasDepth) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+        glEnable(GL_DEPTH_TEST);
+        checkGLError("normals pass");
+    }
+}
+
+bool Renderer::createPickTargets() {
+    const int size = 2 * kPickRadius + 1;
+    glGenRenderbuffers(1, &m_pickColorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_pickColorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_R32UI, size, size);
+    glGenRenderbuffers(1, &m_pickDepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_pickDepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_pickFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_pickFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_pickColorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_pickDepthBuffer);
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glGenBuffers(1, &m_pickPBO);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pickPBO);
+    glBufferData(GL_PIXEL_PACK_BUFFER, size * size * sizeof(GLuint), nullptr, GL_STREAM_READ);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Pick framebuffer incomplete: 0x" << std::hex << status << std::dec << std::endl;
+        deletePickTargets();
+        return false;
     }
+    return true;
+}
+
+void Renderer::deletePickTargets() {
+    if (m_pickFence) glDeleteSync(m_pickFence);
+    if (m_pickFBO) glDeleteFramebuffers(1, &m_pickFBO);
+    if (m_pickColorBuffer) glDeleteRenderbuffers(1, &m_pickColorBuffer);
+    if (m_pickDepthBuffer) glDeleteRenderbuffers(1, &m_pickDepthBuffer);
+    if (m_pickPBO) glDeleteBuffers(1, &m_pickPBO);
+    m_pickFence = nullptr;
+    m_pickFBO = m_pickColorBuffer = m_pickDepthBuffer = m_pickPBO = 0;
+}
+
+bool Renderer::requestPick(const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model,
+                           int x, int y, int width, int height) {
+    if (!m_mesh || m_indexCount == 0 || !m_shaderProgramPick || width <= 0 || height <= 0) {
+        return false;
+    }
+    if (!m_pickFBO && !createPickTargets()) {
+        return false;
+    }
+    if (m_pickFence) {
+        glDeleteSync(m_pickFence);
+        m_pickFence = nullptr;
+    }
+
+    // Zoom the projection onto the pick window centred on the cursor pixel
+    // (like gluPickMatrix), so the whole ID buffer is that window
+    const int size = 2 * kPickRadius + 1;
+    const float centerX = 2.0f * (static_cast<float>(x) + 0.5f) / static_cast<float>(width) - 1.0f;
+    const float centerY = 1.0f - 2.0f * (static_cast<float>(y) + 0.5f) / static_cast<float>(height);
+    glm::mat4 pickMatrix(1.0f);
+    pickMatrix[0][0] = static_cast<float>(width) / size;
+    pickMatrix[1][1] = static_cast<float>(height) / size;
+    pickMatrix[3][0] = -centerX * pickMatrix[0][0];
+    pickMatrix[3][1] = -centerY * pickMatrix[1][1];
+    const glm::mat4 pickProjection = pickMatrix * projection;
+    // render() sets the real camera again before anything else is drawn
+    updateFrameUniforms(pickProjection, view, model, glm::vec3(0.0f, -1.0f, 0.0f));
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_pickFBO);
+    glViewport(0, 0, size, size);
+    const GLuint noTriangle[4] = {0, 0, 0, 0};
+    const GLfloat farDepth = 1.0f;
+    glClearBufferuiv(GL_COLOR, 0, noTriangle);
+    glClearBufferfv(GL_DEPTH, 0, &farDepth);
+    glEnable(GL_DEPTH_TEST);
+    if (m_cullingEnabled) {
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+    } else {
+        glDisable(GL_CULL_FACE);
+    }
+
+    // Always the full mesh, so IDs are mesh triangles; the window is only a
+    // few pixels wide, so culling leaves a handful of clusters
+    glUseProgram(m_shaderProgramPick);
+    glBindVertexArray(m_VAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+    if (m_clusters.empty()) {
+        glUniform1i(m_pickUniforms.primitiveBase, 0);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indexCount), GL_UNSIGNED_INT, 0);
+    } else {
+        std::vector<MeshClusters::Range> ranges;
+        m_clusters.cull(pickProjection * view * model, glm::vec2(size), 0.0f, ranges);
+        for (const MeshClusters::Range& range : ranges) {
+            glUniform1i(m_pickUniforms.primitiveBase, static_cast<GLint>(range.firstTriangle));
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(range.triangleCount * 3), GL_UNSIGNED_INT,
+                           reinterpret_cast<const void*>(size_t(range.firstTriangle) * 3 * sizeof(unsigned int)));
+        }
+    }
+    glBindVertexArray(0);
+
+    // Into the pixel buffer: returns at once, the copy happens when the GPU gets there
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pickPBO);
+    glReadPixels(0, 0, size, size, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_pickFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush(); // so the fence is reached without anyone waiting on it
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, width, height);
+    checkGLError("pick pass");
+    return m_pickFence != nullptr;
+}
+
+bool Renderer::pollPick(unsigned int& triangle) {
+    if (!m_pickFence) {
+        return false;
+    }
+    const GLenum status = glClientWaitSync(m_pickFence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+    glDeleteSync(m_pickFence);
+    m_pickFence = nullptr;
+    triangle = kNoTriangle;
+    if (status == GL_WAIT_FAILED) {
+        return true;
+    }
+
+    // Rows come bottom up; the centre texel is the cursor pixel either way
+    const int size = 2 * kPickRadius + 1;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pickPBO);
+    const GLuint* ids = static_cast<const GLuint*>(
+        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size * size * sizeof(GLuint), GL_MAP_READ_BIT));
+    if (ids) {
+        int bestDistance2 = std::numeric_limits<int>::max();
+        for (int row = 0; row < size; ++row) {
+            for (int column = 0; column < size; ++column) {
+                const GLuint id = ids[row * size + column];
+                const int distance2 = (row - kPickRadius) * (row - kPickRadius) +
+                                      (column - kPickRadius) * (column - kPickRadius);
+                if (id != 0 && distance2 < bestDistance2) {
+                    bestDistance2 = distance2;
+                    triangle = id - 1;
+                }
+            }
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
+
+bool Renderer::validateWireframeState() {
+    if (m_edgeEBO == 0 || m_VAO == 0) {
+        std::cerr << "ERROR: Wireframe buffers not initialized (VAO=" << m_VAO
+                  << ", edgeEBO=" << m_edgeEBO << ")" << std::endl;
+        return false;
+    }
+    
+    // Clear any pending OpenGL errors so the ones below are our own
+    while (glGetError() != GL_NO_ERROR) {
+    }
+    
+    // Verify VAO exists before binding
+    if (!glIsVertexArray(m_VAO)) {
+        std::cerr << std::endl << "=== WIREFRAME RENDERING ERROR ===" << std::endl;
+        std::cerr << "ERROR: m_VAO=" << m_VAO << " is not a valid vertex array object!" << std::endl;
+        std::cerr << "  This could mean the VAO was deleted or created in a different context" << std::endl;
+        std::cerr << "  m_VBO=" << m_VBO << ", m_EBO=" << m_EBO << ", m_edgeEBO=" << m_edgeEBO << std::endl;
+        std::cerr << "  m_indexCount=" << m_indexCount << ", m_edgeIndexCount=" << m_edgeIndexCount << std::endl;
+        std::cerr << "========================================" << std::endl << std::endl;
+        return false;
+    }
+    
+    GLint previousVAO = 0;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previousVAO);
+    glBindVertexArray(m_VAO);
+    GLenum err = glGetError();
+    if (err != GL_NO_ERROR) {
+        std::cerr << "OpenGL error after glBindVertexArray(m_VAO=" << m_VAO << "): 0x"
+                  << std::hex << err << std::dec << " (previous VAO binding was " << previousVAO << ")" << std::endl;
+        return false;
+    }
+    
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_edgeEBO);
+    GLint bufferBinding = 0;
+    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &bufferBinding);
+    bool valid = true;
+    if (bufferBinding != static_cast<GLint>(m_edgeEBO)) {
+        std::cerr << "ERROR: ELEMENT_ARRAY_BUFFER binding mismatch: expected="
+                  << m_edgeEBO << ", actual=" << bufferBinding << std::endl;
+        valid = false;
+    }
+    
+    // Verify buffer size matches expected count
+    GLint bufferSize = 0;
+    glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &bufferSize);
+    const size_t expectedSize = m_edgeIndexCount * sizeof(unsigned int);
+    if (bufferSize != static_cast<GLint>(expectedSize)) {
+        std::cerr << "WARNING: Buffer size mismatch: expected=" << expectedSize
+                  << " bytes, actual=" << bufferSize << " bytes" << std::endl;
+    }
+    
+    // GL_LINES needs an even count that fits in GLsizei
+    if (m_edgeIndexCount % 2 != 0 ||
+        m_edgeIndexCount > static_cast<size_t>(std::numeric_limits<GLsizei>::max())) {
+        std::cerr << "ERROR: cannot draw " << m_edgeIndexCount << " edge indices as GL_LINES" << std::endl;
+        valid = false;
+    }
+    
+    glBindVertexArray(0);
+    return valid;
+}
+
+void Renderer::checkGLError(const char* where) const {
+    // With debug output the driver reports errors through debugMessageCallback
+    if (!m_debugValidation || m_debugOutput) {
+        return;
+    }
+    for (GLenum err = glGetError(); err != GL_NO_ERROR; err = glGetError()) {
+        std::cerr << "OpenGL error in " << where << ": 0x" << std::hex << err << std::dec << std::endl;
+    }
+}
+
+void Renderer::setDebugValidation(bool enabled) {
+    m_debugValidation = enabled;
+    if (enabled && !m_debugOutput) {
+        // Core since 4.3; on older contexts glad loads the same entry points from
+        // KHR_debug when the driver has it
+        if (glDebugMessageCallback) {
+            glEnable(GL_DEBUG_OUTPUT);
+            // Report from inside the failing call, so a breakpoint in the callback shows the culprit
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+            glDebugMessageCallback(debugMessageCallback, nullptr);
+            glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+            m_debugOutput = true;
+            std::cout << "GL debug validation: KHR_debug output" << std::endl;
+        } else {
+            std::cout << "GL debug validation: glGetError after each pass (KHR_debug not available)" << std::endl;
+        }
+    } else if (!enabled && m_debugOutput) {
+        glDebugMessageCallback(nullptr, nullptr);
+        glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        glDisable(GL_DEBUG_OUTPUT);
+        m_debugOutput = false;
+    }
+}
+
+void APIENTRY Renderer::debugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                             GLsizei length, const GLchar* message, const void* userParam) {
+    (void)source;
+    (void)length;
+    (void)userParam;
+    const char* severityName = severity == GL_DEBUG_SEVERITY_HIGH ? "high"
+                             : severity == GL_DEBUG_SEVERITY_MEDIUM ? "medium"
+                             : severity == GL_DEBUG_SEVERITY_LOW ? "low" : "info";
+    std::cerr << "GL debug [" << severityName << (type == GL_DEBUG_TYPE_ERROR ? ", error" : "")
+              << ", id " << id << "]: " << message << std::endl;
+}
+
+Renderer::UniformLocations Renderer::queryUniforms(GLuint program) {
+    // Names a program does not use come back as -1, which glUniform* ignores
+    UniformLocations u;
+    u.positionOffset = glGetUniformLocation(program, "positionOffset");
+    u.positionScale = glGetUniformLocation(program, "positionScale");
+    u.facetLookup = glGetUniformLocation(program, "facetLookup");
+    u.octahedralNormals = glGetUniformLocation(program, "octahedralNormals");
+    u.primitiveBase = glGetUniformLocation(program, "primitiveBase");
+    u.color = glGetUniformLocation(program, "lineColor");
+    if (u.color < 0) {
+        u.color = glGetUniformLocation(program, "color");
+    }
+    return u;
 }
 
 // setRenderMode removed in favor of independent toggles
@@ -620,6 +1065,13 @@ bool Renderer::loadShaders() {
     glDeleteShader(vSolid);
     glDeleteShader(fSolid);
     if (!m_shaderProgramSolid) return false;
+    m_solidUniforms = queryUniforms(m_shaderProgramSolid);
+    bindFrameUniforms(m_shaderProgramSolid);
+    // Texture units of the facet lookup buffers (see uploadFacetBuffers)
+    glUseProgram(m_shaderProgramSolid);
+    glUniform1i(glGetUniformLocation(m_shaderProgramSolid, "facetData"), 0);
+    glUniform1i(glGetUniformLocation(m_shaderProgramSolid, "triangleFacets"), 1);
+    glUseProgram(0);
 
     // Load wireframe shaders from files
     std::ifstream wireFragFile("shaders/wireframe.frag");
@@ -638,6 +1090,11 @@ bool Renderer::loadShaders() {
     glDeleteShader(vWire);
     glDeleteShader(fWire);
     if (!m_shaderProgramWireframe) return false;
+    m_wireframeUniforms = queryUniforms(m_shaderProgramWireframe);
+    if (m_wireframeUniforms.color < 0) {
+        std::cerr << "ERROR: Failed to get uniform locations in wireframe shader" << std::endl;
+    }
+    bindFrameUniforms(m_shaderProgramWireframe);
 
     // Load normals debug shaders from files
     std::ifstream normalsVSFile("shaders/normals.vert");
@@ -659,6 +1116,28 @@ bool Renderer::loadShaders() {
     glDeleteShader(vNorm);
     glDeleteShader(fNorm);
     if (!m_shaderProgramNormals) return false;
+    m_normalsUniforms = queryUniforms(m_shaderProgramNormals);
+    bindFrameUniforms(m_shaderProgramNormals);
+
+    // Triangle ID shader for GPU picking; shares the solid vertex shader
+    std::ifstream pickFragFile("shaders/pick.frag");
+    if (!pickFragFile.is_open()) {
+        std::cerr << "Failed to open pick fragment shader file" << std::endl;
+        return false;
+    }
+    std::stringstream pickFragStream;
+    pickFragStream << pickFragFile.rdbuf();
+    std::string pickFragCode = pickFragStream.str();
+
+    GLuint vPick = compileShader(vertexCode, GL_VERTEX_SHADER);
+    GLuint fPick = compileShader(pickFragCode, GL_FRAGMENT_SHADER);
+    if (!vPick || !fPick) return false;
+    m_shaderProgramPick = linkProgram(vPick, fPick);
+    glDeleteShader(vPick);
+    glDeleteShader(fPick);
+    if (!m_shaderProgramPick) return false;
+    m_pickUniforms = queryUniforms(m_shaderProgramPick);
+    bindFrameUniforms(m_shaderProgramPick);
 
     return true;
 }
@@ -698,56 +1177,3 @@ GLuint Renderer::linkProgram(GLuint vertexShader, GLuint fragmentShader) {
     
     return program;
 }
-
-void Renderer::setupFacetNormals() {
-    m_normalsVertexCount = 0;
-    if (!m_mesh || m_mesh->facets.empty()) return;
-
-    // Compute scale from mesh extent
-    float length = glm::max(0.001f, m_mesh->getMaxExtent() * m_normalLengthScale);
-
-    std::vector<glm::vec3> lineVerts;
-    lineVerts.reserve(m_mesh->facets.size() * 2);
-
-    for (const auto& facet : m_mesh->facets) {
-        if (facet.indices.size() < 3) continue;
-        // Compute centroid
-        glm::vec3 centroid(0.0f);
-        for (unsigned int idx : facet.indices) {
-            centroid += m_mesh->vertices[idx].position;
-        }
-        centroid /= static_cast<float>(facet.indices.size());
-        // Compute normal using Newell's method for robustness
-        glm::vec3 normal(0.0f);
-        for (size_t i = 0; i < facet.indices.size(); ++i) {
-            const glm::vec3& v1 = m_mesh->vertices[facet.indices[i]].position;
-            const glm::vec3& v2 = m_mesh->vertices[facet.indices[(i + 1) % facet.indices.size()]].position;
-            normal.x += (v1.y - v2.y) * (v1.z + v2.z);
-            normal.y += (v1.z - v2.z) * (v1.x + v2.x);
-            normal.z += (v1.x - v2.x) * (v1.y + v2.y);
-        }
-        float len = glm::length(normal);
-        if (len > 1e-6f) normal /= len; else {
-            // Fallback to cross of first two edges
-            const glm::vec3& a = m_mesh->vertices[facet.indices[0]].position;
-            const glm::vec3& b = m_mesh->vertices[facet.indices[1]].position;
-            const glm::vec3& c = m_mesh->vertices[facet.indices[2]].position;
-            normal = glm::normalize(glm::cross(b - a, c - a));
-        }
-        lineVerts.push_back(centroid);
-        lineVerts.push_back(centroid + normal * length);
-    }
-
-    if (lineVerts.empty()) return;
-
-    // Create VAO/VBO for lines
-    glGenVertexArrays(1, &m_normalsVAO);
-    glGenBuffers(1, &m_normalsVBO);
-    glBindVertexArray(m_normalsVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_normalsVBO);
-    glBufferData(GL_ARRAY_BUFFER, lineVerts.size() * sizeof(glm::vec3), lineVerts.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
-    m_normalsVertexCount = static_cast<GLsizei>(lineVerts.size());
-}
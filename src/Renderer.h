@@ -1,10 +1,57 @@
 #pragma once
 
 #include "Mesh.h"
+#include "MeshBVH.h"
+#include "MeshClusters.h"
+#include "MeshSimplifier.h"
+#include "progress/AsyncProgress.h"
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <atomic>
 #include <string>
 #include <memory>
+#include <thread>
+#include <vector>
+
+// Forward declaration - can be Progress_abstract (global) or gui::Progress_abstract
+class Progress_abstract;
+
+// Options for the GPU copy of a mesh (the CPU-side Mesh is never changed)
+struct MeshRenderOptions {
+    // Store positions as 16 bits per axis within the mesh bounding box and
+    // facet normals octahedral-encoded
+    bool quantize = false;
+    // Largest allowed position error in model units; a mesh whose quantized
+    // positions would move further keeps full floats. Negative: 1e-4 of the
+    // largest mesh extent
+    float quantizeTolerance = -1.0f;
+    // Build simplified levels of detail for large meshes (see Renderer::kLodMinTriangles)
+    bool levelOfDetail = true;
+};
+
+// CPU-side render buffers for one mesh. Renderer::prepareMesh builds them without
+// any GL calls, so a loader thread can do it; Renderer::setPreparedMesh uploads them.
+// Exactly one of the float / quantized vectors of each kind is filled.
+struct MeshRenderData {
+    std::unique_ptr<Mesh> mesh;           // triangulated, triangles in cluster order
+    MeshClusters clusters;                // view culling hierarchy over the triangles
+    MeshBVH bvh;                          // ray casting hierarchy over the same triangles
+    std::vector<glm::vec3> positions;     // one per mesh vertex, shared by every pass
+    std::vector<glm::vec4> facetData;     // 2 texels per facet: (normal, 0), (center, 1)
+    // Quantized variants: position = positionOffset + (q / 65535) * positionScale.
+    // w is unused; it keeps each vertex 4-byte aligned for the vertex fetch.
+    std::vector<glm::u16vec4> quantizedPositions;
+    std::vector<glm::u16vec4> quantizedFacetData; // 2 texels per facet: (octahedral normal, 0, 0), (center, 0)
+    glm::vec3 positionOffset{0.0f};
+    glm::vec3 positionScale{1.0f};
+    // One triangle per facet: the facet data is stored in triangle order, so no
+    // triangle -> facet map is needed
+    bool facetDataPerTriangle = false;
+    bool buildLevelsOfDetail = false;     // MeshRenderOptions::levelOfDetail
+    
+    bool isQuantized() const { return !quantizedPositions.empty(); }
+};
 
 class Renderer {
 public:
@@ -12,58 +59,212 @@ public:
     ~Renderer();
     
     bool initialize();
+    // Prepare and upload in one go on the calling (GL) thread
     void setMesh(std::unique_ptr<Mesh> mesh);
+    // Upload buffers built by prepareMesh; must run on the GL thread
+    void setPreparedMesh(std::unique_ptr<MeshRenderData> data);
+    // Triangulate `mesh` and extract its edges if needed, and build its render buffers. Touches no GL
+    // state, so it may run on any thread. Returns nullptr if cancelled.
+    static std::unique_ptr<MeshRenderData> prepareMesh(std::unique_ptr<Mesh> mesh,
+                                                       const MeshRenderOptions& options = MeshRenderOptions(),
+                                                       Progress_abstract* progress = nullptr);
     void render(const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model, const glm::vec3& lightDirection = glm::vec3(0.0f, -1.0f, 0.0f));
     // Draw toggles
     void setDrawSolid(bool enabled) { m_drawSolid = enabled; }
     bool getDrawSolid() const { return m_drawSolid; }
     void setDrawWireframe(bool enabled) { m_drawWireframe = enabled; }
     bool getDrawWireframe() const { return m_drawWireframe; }
+    // Wireframe shows only boundary, non-manifold and feature edges (see EdgeExtractor)
+    void setFeatureEdgesOnly(bool enabled) { m_featureEdgesOnly = enabled; }
+    bool getFeatureEdgesOnly() const { return m_featureEdgesOnly; }
     void setDrawFacetNormals(bool enabled) { m_drawFacetNormals = enabled; }
     bool getDrawFacetNormals() const { return m_drawFacetNormals; }
-    void setNormalLengthScale(float s) { m_normalLengthScale = s; }
+    void setNormalLengthScale(float s) { m_normalLengthScale = s; m_debugGeometryBuilt = false; }
     float getNormalLengthScale() const { return m_normalLengthScale; }
     void setCullingEnabled(bool enabled) { m_cullingEnabled = enabled; }
     bool getCullingEnabled() const { return m_cullingEnabled; }
+    // Size of the viewport render() draws to, for the small-cluster test
+    void setViewportSize(int width, int height) { m_viewportSize = glm::vec2(width, height); }
+    // Clusters that project smaller than this many pixels are not drawn (0: never)
+    void setMinClusterPixels(float pixels) { m_minClusterPixels = pixels; }
+    float getMinClusterPixels() const { return m_minClusterPixels; }
+    // Triangles the last render() drew in the solid pass, after view culling
+    size_t getVisibleTriangleCount() const { return m_visibleTriangleCount; }
+    // Draw calls the last render() issued for the solid pass, one per visible range
+    size_t getSolidDrawCount() const { return m_solidDrawCount; }
+    // Level of detail the last render() drew (0: the full mesh)
+    size_t getLevelOfDetail() const { return m_lodLevel; }
+    // True while the background thread is still simplifying the current mesh
+    bool isBuildingLevelsOfDetail() const { return m_lodWorker.joinable(); }
+    // Upload the levels of detail if the background build has finished; returns
+    // true when new levels became available (the next frame may look different).
+    // render() calls it as well. GL thread only.
+    bool pollLevelsOfDetail();
+    
+    // Meshes with at least this many triangles get simplified levels of detail,
+    // built on a background thread once the full mesh is shown. render() then
+    // draws the coarsest level whose error stays below kLodPixelError on screen.
+    static constexpr size_t kLodMinTriangles = 500000;
+    static constexpr float kLodPixelError = 1.0f;
+    
+    // Debug validation: GL debug output (KHR_debug) where available, glGetError
+    // after each pass otherwise, plus the wireframe state checks. Needs the GL
+    // context; costs frame time, so it is off unless asked for (--gl-debug).
+    void setDebugValidation(bool enabled);
+    bool getDebugValidation() const { return m_debugValidation; }
     
     Mesh* getMesh() const { return m_mesh.get(); }
+    // Ray casting hierarchy over getMesh()'s triangles
+    const MeshBVH& getBVH() const { return m_bvh; }
+    
+    // GPU picking: draw the index of the triangle covering each pixel of a
+    // small window around the cursor into an offscreen integer buffer, depth
+    // tested like the solid pass so hidden surfaces never win, and copy it
+    // into a pixel buffer object. requestPick() returns without waiting for
+    // the GPU; pollPick() delivers the result once a fence says the copy has
+    // landed. Only the clusters inside the pick window are drawn. GL thread only.
+    static constexpr int kPickRadius = 4; // pixels around the cursor searched for a triangle
+    static constexpr unsigned int kNoTriangle = ~0u;
+    // (x, y): window pixel, origin top left, of the width x height viewport
+    // that projection * view * model renders to. A new request replaces a pending one.
+    bool requestPick(const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model,
+                     int x, int y, int width, int height);
+    // True once the pending pick has finished; `triangle` is then the
+    // getMesh() triangle nearest the cursor, or kNoTriangle if none is within kPickRadius
+    bool pollPick(unsigned int& triangle);
+    bool isPickPending() const { return m_pickFence != nullptr; }
+    
+    // Uniform buffer binding point of the FrameUniforms block
+    static constexpr GLuint kFrameUniformsBinding = 0;
+    // Connect a linked program's FrameUniforms block (if it has one) to the
+    // buffer render() fills each frame
+    static void bindFrameUniforms(GLuint program);
     
 private:
+    // CPU mirror of the std140 FrameUniforms block in the shaders
+    struct FrameUniforms {
+        glm::mat4 projection;
+        glm::mat4 view;
+        glm::mat4 model;
+        glm::mat4 modelView;
+        glm::vec4 normalMatrix[3];  // mat3: std140 pads each column to a vec4
+        glm::vec4 lightDirectionVS; // vec3 + padding
+    };
+    
+    // Locations of the per-mesh and per-draw uniforms of one program, looked up once after linking
+    struct UniformLocations {
+        GLint positionOffset = -1;
+        GLint positionScale = -1;
+        GLint facetLookup = -1;
+        GLint octahedralNormals = -1;
+        GLint primitiveBase = -1;
+        GLint color = -1;   // lineColor (wireframe) or color (normals)
+    };
+    
+    // One simplified index range in m_lodEBO
+    struct LodLevel {
+        size_t firstIndex;
+        size_t indexCount;
+        float error; // model units
+    };
+    
+    void updateFrameUniforms(const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model,
+                             const glm::vec3& lightDirection);
+    void applyMeshUniforms();
+    void startLodBuild();
+    void stopLodBuild();
+    size_t selectLevelOfDetail(const glm::mat4& mvp) const;
+    
+    static UniformLocations queryUniforms(GLuint program);
+    static void APIENTRY debugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                              GLsizei length, const GLchar* message, const void* userParam);
+    bool validateWireframeState();
+    void checkGLError(const char* where) const;
     bool loadShaders();
     GLuint compileShader(const std::string& source, GLenum type);
     GLuint linkProgram(GLuint vertexShader, GLuint fragmentShader);
-    void setupMesh();
-    void setupFacetNormals();
+    void uploadMesh(const MeshRenderData& data);
+    void uploadFacetBuffers(const MeshRenderData& data);
+    void deleteFacetBuffers();
+    static bool quantizeMesh(MeshRenderData& data, float tolerance);
+    void buildDebugGeometry();
+    void deleteDebugGeometry();
+    bool createPickTargets();
+    void deletePickTargets();
+    
+    // How the solid shader finds the facet of the triangle being shaded
+    // (values match the facetLookup uniform in fragment.glsl)
+    enum class FacetLookup : GLint {
+        None = 0,           // no facet buffers: normal from screen-space derivatives
+        PrimitiveId = 1,    // the triangle index is the facet index (facet data in triangle order)
+        TriangleFacets = 2  // gl_PrimitiveID indexes the triangle -> facet buffer
+    };
     
     std::unique_ptr<Mesh> m_mesh;
     GLuint m_VAO;
-    GLuint m_VBO;
+    GLuint m_VBO;       // Vertex positions, shared by all passes
     GLuint m_EBO;       // Element buffer for triangles (solid mode)
     GLuint m_edgeEBO;   // Element buffer for edges (wireframe mode)
     GLuint m_shaderProgramSolid;
     GLuint m_shaderProgramWireframe;
+    GLuint m_frameUniformBuffer;
+    UniformLocations m_solidUniforms;
+    UniformLocations m_wireframeUniforms;
+    UniformLocations m_normalsUniforms;
     // Debug: facet normals
     GLuint m_normalsVAO;
     GLuint m_normalsVBO;
     GLuint m_shaderProgramNormals;
     GLsizei m_normalsVertexCount; // number of vertices (2 per facet)
-    // Debug: triangle normals
+    // Debug: triangle normals (triangle edges are drawn from m_EBO)
     GLuint m_triNormalsVAO;
     GLuint m_triNormalsVBO;
     GLsizei m_triNormalsVertexCount; // number of vertices (2 per triangle)
-    // Debug: triangle edges (from triangulation)
-    GLuint m_triEdgesVAO;
-    GLuint m_triEdgesVBO;
-    GLsizei m_triEdgesVertexCount; // number of vertices (2 per edge * 3 per tri)
-    // Solid-mode dedicated VBO/VAO with per-triangle facet normals to hide triangulation
-    GLuint m_solidVAO;
-    GLuint m_solidVBO;
-    GLsizei m_solidVertexCount; // number of vertices for glDrawArrays
+    bool m_debugGeometryBuilt;       // debug lines are built when first shown
+    // GPU picking (see requestPick); targets are created on first use
+    GLuint m_shaderProgramPick;
+    UniformLocations m_pickUniforms;
+    GLuint m_pickFBO;
+    GLuint m_pickColorBuffer;   // GL_R32UI, triangle index + 1
+    GLuint m_pickDepthBuffer;
+    GLuint m_pickPBO;           // read-back target of the ID window
+    GLsync m_pickFence;         // set while a pick is in flight
+    // Facet normals and centers for flat shading, fetched by primitive ID to hide triangulation
+    GLuint m_facetDataBuffer;
+    GLuint m_facetDataTexture;       // RGBA32F (RGBA16 when quantized) buffer texture, 2 texels per facet
+    GLuint m_triangleFacetBuffer;
+    GLuint m_triangleFacetTexture;   // R32UI buffer texture, facet of each triangle
+    FacetLookup m_facetLookup;
+    // Dequantization of the uploaded positions (identity for float buffers)
+    bool m_quantized;
+    glm::vec3 m_positionOffset;
+    glm::vec3 m_positionScale;
     bool m_drawFacetNormals;
     float m_normalLengthScale; // relative to model extent
     bool m_cullingEnabled; // back-face culling toggle
     bool m_drawSolid;     // draw solid triangles
     bool m_drawWireframe; // draw wireframe edges
+    bool m_featureEdgesOnly; // wireframe draws the non-smooth edge prefix only
+    bool m_debugValidation;  // see setDebugValidation
+    bool m_debugOutput;      // KHR_debug callback installed
+    // View culling of the solid pass
+    MeshClusters m_clusters;
+    std::vector<MeshClusters::Range> m_visibleRanges; // reused every frame
+    MeshBVH m_bvh;
+    glm::vec2 m_viewportSize;
+    float m_minClusterPixels;
+    size_t m_visibleTriangleCount;
+    size_t m_solidDrawCount;
+    // Levels of detail of the solid pass, coarser with each entry; the
+    // worker only reads m_mesh, which outlives it (see setPreparedMesh)
+    GLuint m_lodEBO;
+    std::vector<LodLevel> m_lodLevels;
+    size_t m_lodLevel;
+    std::thread m_lodWorker;
+    AsyncProgress m_lodProgress;
+    std::atomic<bool> m_lodFinished{false};
+    std::vector<MeshSimplifier::Level> m_lodResult; // written by the worker before m_lodFinished is set
     size_t m_indexCount;     // Number of triangle indices for rendering
     size_t m_edgeIndexCount; // Number of edge indices for wireframe
+    size_t m_featureEdgeIndexCount; // Leading edge indices that are not smooth edges
 };
@@ -1,9 +1,17 @@
 #include "STLLoader.h"
 #include "progress/Progress_abstract.h"  // Include for mySTLviewer standalone compilation
+#include "MappedFile.h"
 #include <fstream>
-#include <sstream>
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <vector>
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
 
 std::unique_ptr<Mesh> STLLoader::load(const std::string& filename, Progress_abstract* progress) {
     if (isBinarySTL(filename)) {
@@ -43,30 +51,116 @@ bool STLLoader::isBinarySTL(const std::string& filename) {
     return true; // Likely binary
 }
 
+namespace {
+
+// Binary STL layout: 80-byte header, uint32 triangle count, then fixed 50-byte records
+constexpr size_t kHeaderSize = 84;
+constexpr size_t kRecordSize = 50;
+// Triangles decoded between progress updates (and per read in the stream fallback)
+constexpr uint32_t kTrianglesPerBlock = 1u << 18;
+// Work unit handed to one thread when a block is decoded in parallel
+constexpr uint32_t kTrianglesPerChunk = 4096;
+
+} // namespace
+
+void STLLoader::decodeBinaryTriangles(const char* records, uint32_t firstTriangle, uint32_t count, Mesh& mesh) {
+    for (uint32_t t = 0; t < count; ++t) {
+        const char* record = records + static_cast<size_t>(t) * kRecordSize;
+
+        // Skip normal (we'll compute from winding); records are unaligned, so copy out
+        glm::vec3 positions[3];
+        for (int j = 0; j < 3; ++j) {
+            float vertex[3];
+            std::memcpy(vertex, record + 12 + j * 12, 12);
+            positions[j] = glm::vec3(vertex[0], vertex[1], vertex[2]);
+        }
+
+        // Compute normal from winding order
+        glm::vec3 n = glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
+        if (glm::length(n) > 1e-12f) {
+            n = glm::normalize(n);
+        } else {
+            n = glm::vec3(0, 0, 1); // fallback
+        }
+
+        const size_t triangle = static_cast<size_t>(firstTriangle) + t;
+        const unsigned int baseIndex = static_cast<unsigned int>(triangle * 3);
+        for (int j = 0; j < 3; ++j) {
+            mesh.vertices[baseIndex + j].position = positions[j];
+            mesh.vertices[baseIndex + j].normal = n;
+        }
+
+        // Create a triangular facet with flipped winding order
+        unsigned int* facet = mesh.facets.indices.data() + triangle * 3;
+        facet[0] = baseIndex;
+        facet[1] = baseIndex + 2;
+        facet[2] = baseIndex + 1;
+    }
+}
+
+void STLLoader::decodeBinaryTrianglesParallel(const char* records, uint32_t firstTriangle, uint32_t count, Mesh& mesh) {
+    // Records are fixed size and every triangle owns its own output slots,
+    // so chunks can be decoded independently and in any order
+    const int64_t numChunks = (static_cast<int64_t>(count) + kTrianglesPerChunk - 1) / kTrianglesPerChunk;
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) if (numChunks > 1)
+#endif
+    for (int64_t chunk = 0; chunk < numChunks; ++chunk) {
+        const uint32_t offset = static_cast<uint32_t>(chunk) * kTrianglesPerChunk;
+        const uint32_t chunkCount = std::min(kTrianglesPerChunk, count - offset);
+        decodeBinaryTriangles(records + static_cast<size_t>(offset) * kRecordSize,
+                              firstTriangle + offset, chunkCount, mesh);
+    }
+}
+
 std::unique_ptr<Mesh> STLLoader::loadBinary(const std::string& filename, Progress_abstract* progress) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open file: " << filename << std::endl;
+    // Map the whole file and decode records in place; fall back to block reads if mapping fails
+    MappedFile mapped;
+    std::ifstream file;
+    size_t fileSize = 0;
+    if (mapped.open(filename)) {
+        fileSize = mapped.size();
+    } else {
+        file.open(filename, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file: " << filename << std::endl;
+            return nullptr;
+        }
+        fileSize = static_cast<size_t>(file.tellg());
+    }
+
+    if (fileSize < kHeaderSize) {
+        std::cerr << "Binary STL file is too short: " << filename << std::endl;
         return nullptr;
     }
-    
+
+    // Read number of triangles (after the 80-byte header)
+    uint32_t numTriangles = 0;
+    if (mapped.isOpen()) {
+        std::memcpy(&numTriangles, mapped.data() + 80, 4);
+    } else {
+        file.seekg(80);
+        file.read(reinterpret_cast<char*>(&numTriangles), 4);
+    }
+
+    // Never decode past the end of a truncated file
+    const size_t availableTriangles = (fileSize - kHeaderSize) / kRecordSize;
+    if (numTriangles > availableTriangles) {
+        std::cerr << "Warning: STL header declares " << numTriangles << " triangles but file only holds "
+                  << availableTriangles << std::endl;
+        numTriangles = static_cast<uint32_t>(availableTriangles);
+    }
+
     auto mesh = std::make_unique<Mesh>();
-    
-    // Skip 80-byte header
-    file.seekg(80);
-    
-    // Read number of triangles
-    uint32_t numTriangles;
-    file.read(reinterpret_cast<char*>(&numTriangles), 4);
-    
+
     if (progress) {
         progress->setMessage("Reading triangles...");
         progress->setProgress(0.0f);
     }
-    
-    mesh->vertices.reserve(numTriangles * 3);
-    mesh->facets.reserve(numTriangles);
-    
+
+    mesh->vertices.resize(static_cast<size_t>(numTriangles) * 3);
+    mesh->facets.resizeTriangles(numTriangles);
+
     // Progress tracking
     uint32_t lastPercent = 0;
     if (numTriangles == 0 && progress) {
@@ -74,43 +168,31 @@ std::unique_ptr<Mesh> STLLoader::loadBinary(const std::string& filename, Progres
         progress->setProgress(1.0f);
     }
 
-    for (uint32_t i = 0; i < numTriangles; ++i) {
-        // Skip normal (we'll compute from winding)
-        file.seekg(12, std::ios::cur);
-        
-        // Read 3 vertices
-        glm::vec3 positions[3];
-        for (int j = 0; j < 3; ++j) {
-            float vertex[3];
-            file.read(reinterpret_cast<char*>(vertex), 12);
-            positions[j] = glm::vec3(vertex[0], vertex[1], vertex[2]);
+    std::vector<char> block;
+    if (!mapped.isOpen()) {
+        block.resize(static_cast<size_t>(std::min(numTriangles, kTrianglesPerBlock)) * kRecordSize);
+    }
+
+    for (uint32_t first = 0; first < numTriangles; first += kTrianglesPerBlock) {
+        if (progress && progress->isCancelled()) {
+            return nullptr;
         }
-        
-        // Compute normal from winding order
-        glm::vec3 n = glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
-        if (glm::length(n) > 1e-12f) {
-            n = glm::normalize(n);
+        const uint32_t count = std::min(kTrianglesPerBlock, numTriangles - first);
+
+        if (mapped.isOpen()) {
+            decodeBinaryTrianglesParallel(mapped.data() + kHeaderSize + static_cast<size_t>(first) * kRecordSize,
+                                          first, count, *mesh);
         } else {
-            n = glm::vec3(0, 0, 1); // fallback
-        }
-        
-        // Create vertices with computed normal
-        unsigned int baseIndex = mesh->vertices.size();
-        for (int j = 0; j < 3; ++j) {
-            Vertex v;
-            v.position = positions[j];
-            v.normal = n;
-            mesh->vertices.push_back(v);
+            file.read(block.data(), static_cast<std::streamsize>(count) * kRecordSize);
+            if (!file) {
+                std::cerr << "Failed to read triangles from: " << filename << std::endl;
+                return nullptr;
+            }
+            decodeBinaryTrianglesParallel(block.data(), first, count, *mesh);
         }
-        
-        // Create a triangular facet with flipped winding order
-        mesh->facets.push_back(Facet{baseIndex, baseIndex + 2, baseIndex + 1});
-        
-        // Skip attribute byte count
-        file.seekg(2, std::ios::cur);
 
         // Update progress bar only when percentage changes (max 100 prints)
-        uint32_t percent = numTriangles ? static_cast<uint32_t>(((i + 1) * 100ULL) / numTriangles) : 100;
+        uint32_t percent = static_cast<uint32_t>(((first + count) * 100ULL) / numTriangles);
         if (percent != lastPercent && progress) {
             lastPercent = percent;
             float progressValue = percent / 100.0f;
@@ -118,64 +200,101 @@ std::unique_ptr<Mesh> STLLoader::loadBinary(const std::string& filename, Progres
             progress->setProgress(progressValue);
         }
     }
-    
+
     if (progress) {
         progress->setMessage("Processing geometry...");
         progress->setProgress(1.0f);
     }
-    
+
     mesh->calculateBounds();
-    
+
     return mesh;
 }
 
-std::unique_ptr<Mesh> STLLoader::loadASCII(const std::string& filename, Progress_abstract* progress) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open file: " << filename << std::endl;
+namespace {
+
+// Target size of the byte ranges ASCII files are split into for parallel parsing
+constexpr size_t kAsciiChunkBytes = 1u << 20;
+
+// Whitespace as seen by istream in the "C" locale; lines never contain '\n'
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p)) ++p;
+    return p;
+}
+
+inline const char* findLineEnd(const char* p, const char* end) {
+    const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return nl ? static_cast<const char*>(nl) : end;
+}
+
+// True if the token at p is exactly `keyword` (followed by whitespace or end of line)
+inline bool isKeyword(const char* p, const char* lineEnd, const char* keyword, size_t length) {
+    return static_cast<size_t>(lineEnd - p) >= length &&
+           std::memcmp(p, keyword, length) == 0 &&
+           (p + length == lineEnd || isBlank(p[length]));
+}
+
+// Parse one float token like `istream >> float` would. Returns the position after
+// the number, or nullptr if there is no number at p.
+const char* parseFloat(const char* p, const char* end, float& value) {
+    p = skipBlanks(p, end);
+    if (p < end && *p == '+') {
+        ++p; // istream accepts an explicit '+', from_chars does not
+    }
+    // Reject the inf/nan spellings from_chars knows but istream does not
+    const char* digits = (p < end && *p == '-') ? p + 1 : p;
+    if (digits >= end || !((*digits >= '0' && *digits <= '9') || *digits == '.')) {
         return nullptr;
     }
-    
-    auto mesh = std::make_unique<Mesh>();
-    std::string line;
-    glm::vec3 currentNormal;
-    std::vector<glm::vec3> currentTriangle;
-    
-    if (progress) {
-        progress->setMessage("Reading file...");
-        progress->setProgress(0.0f);
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto result = std::from_chars(p, end, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+#else
+    // Standard library without floating-point from_chars: strtof on a bounded copy
+    char buffer[64];
+    size_t length = 0;
+    while (p + length < end && length + 1 < sizeof(buffer) && !isBlank(p[length])) {
+        buffer[length] = p[length];
+        ++length;
     }
-    
-    // Determine total file size (bytes) for progress estimation
-    std::ifstream fsize(filename, std::ios::binary);
-    std::streampos totalBytes = 0;
-    if (fsize.is_open()) {
-        fsize.seekg(0, std::ios::end);
-        totalBytes = fsize.tellg();
-    }
-    std::streampos approxRead = 0;
-    uint32_t lastPercent = 0;
-    
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string keyword;
-        iss >> keyword;
-        
-        if (keyword == "facet") {
-            std::string normalStr;
-            iss >> normalStr; // "normal"
-            float nx, ny, nz;
-            iss >> nx >> ny >> nz;
+    buffer[length] = '\0';
+    char* parsedEnd = nullptr;
+    value = std::strtof(buffer, &parsedEnd);
+    return parsedEnd != buffer ? p + (parsedEnd - buffer) : nullptr;
+#endif
+}
+
+// Parse complete `facet ... endfacet` blocks in [begin, end), appending three
+// vertices (with winding normal) per triangle. Follows the line-based rules of the
+// previous getline/istringstream parser: only the first token of each line counts.
+void parseAsciiRange(const char* begin, const char* end, std::vector<Vertex>& out) {
+    glm::vec3 currentTriangle[3];
+    size_t currentCount = 0; // may exceed 3 for malformed facets, which are then dropped
+
+    const char* line = begin;
+    while (line < end) {
+        const char* lineEnd = findLineEnd(line, end);
+        const char* p = skipBlanks(line, lineEnd);
+
+        if (isKeyword(p, lineEnd, "facet", 5)) {
             // Skip normal, we'll compute from winding
-            currentTriangle.clear();
-        }
-        else if (keyword == "vertex") {
-            float x, y, z;
-            iss >> x >> y >> z;
-            currentTriangle.push_back(glm::vec3(x, y, z));
-        }
-        else if (keyword == "endfacet") {
-            if (currentTriangle.size() == 3) {
+            currentCount = 0;
+        } else if (isKeyword(p, lineEnd, "vertex", 6)) {
+            float xyz[3] = {0.0f, 0.0f, 0.0f};
+            const char* q = p + 6;
+            for (int k = 0; k < 3 && q; ++k) {
+                q = parseFloat(q, lineEnd, xyz[k]);
+            }
+            if (currentCount < 3) {
+                currentTriangle[currentCount] = glm::vec3(xyz[0], xyz[1], xyz[2]);
+            }
+            ++currentCount;
+        } else if (isKeyword(p, lineEnd, "endfacet", 8)) {
+            if (currentCount == 3) {
                 // Compute normal from winding order
                 glm::vec3 n = glm::cross(currentTriangle[1] - currentTriangle[0], currentTriangle[2] - currentTriangle[0]);
                 if (glm::length(n) > 1e-12f) {
@@ -183,42 +302,145 @@ std::unique_ptr<Mesh> STLLoader::loadASCII(const std::string& filename, Progress
                 } else {
                     n = glm::vec3(0, 0, 1); // fallback
                 }
-                
-                unsigned int baseIndex = mesh->vertices.size();
                 for (const auto& pos : currentTriangle) {
                     Vertex v;
                     v.position = pos;
                     v.normal = n;
-                    mesh->vertices.push_back(v);
+                    out.push_back(v);
                 }
-                // Create a triangular facet with flipped winding order
-                mesh->facets.push_back(Facet{baseIndex, baseIndex + 2, baseIndex + 1});
             }
         }
-        // Progress update by file position when available, else by approximate bytes
-        std::streampos pos = file.tellg();
-        if (pos == std::streampos(-1)) {
-            approxRead += static_cast<std::streampos>(line.size() + 1);
-            pos = approxRead;
+
+        line = lineEnd + 1;
+    }
+}
+
+// First line start at or after `from` whose first token is `facet`. Parsing state
+// resets on such lines, so ranges split there parse exactly like the whole file.
+const char* findFacetBoundary(const char* begin, const char* from, const char* end) {
+    const char* line = from;
+    if (line > begin && line[-1] != '\n') {
+        line = findLineEnd(line, end) + 1;
+    }
+    while (line < end) {
+        const char* lineEnd = findLineEnd(line, end);
+        if (isKeyword(skipBlanks(line, lineEnd), lineEnd, "facet", 5)) {
+            return line;
+        }
+        line = lineEnd + 1;
+    }
+    return end;
+}
+
+} // namespace
+
+std::unique_ptr<Mesh> STLLoader::loadASCII(const std::string& filename, Progress_abstract* progress) {
+    // Scan a mapping of the file when possible, otherwise a buffer read in one go
+    MappedFile mapped;
+    std::vector<char> buffer;
+    const char* data = nullptr;
+    size_t size = 0;
+    if (mapped.open(filename)) {
+        data = mapped.data();
+        size = mapped.size();
+    } else {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file: " << filename << std::endl;
+            return nullptr;
         }
-        if (totalBytes > 0 && progress) {
-            uint32_t percent = static_cast<uint32_t>((static_cast<long double>(pos) * 100.0L) / static_cast<long double>(totalBytes));
-            if (percent > 100) percent = 100;
+        buffer.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        data = buffer.data();
+        size = buffer.size();
+    }
+    const char* end = data + size;
+
+    auto mesh = std::make_unique<Mesh>();
+
+    if (progress) {
+        progress->setMessage("Reading file...");
+        progress->setProgress(0.0f);
+    }
+
+    // Split at facet boundaries into roughly equal byte ranges
+    const size_t numRanges = std::max<size_t>(1, size / kAsciiChunkBytes);
+    std::vector<const char*> bounds(numRanges + 1);
+    bounds[0] = data;
+    for (size_t i = 1; i < numRanges; ++i) {
+        const char* target = std::max(bounds[i - 1], data + (size / numRanges) * i);
+        bounds[i] = findFacetBoundary(data, target, end);
+    }
+    bounds[numRanges] = end;
+
+    std::vector<std::vector<Vertex>> rangeVertices(numRanges);
+    std::atomic<size_t> bytesParsed{0};
+    std::atomic<bool> cancelled{false};
+    uint32_t lastPercent = 0;
+
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) if (numRanges > 1)
+#endif
+    for (long long r = 0; r < static_cast<long long>(numRanges); ++r) {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            continue; // An OpenMP loop cannot break; drain the remaining ranges
+        }
+        parseAsciiRange(bounds[r], bounds[r + 1], rangeVertices[r]);
+        size_t done = bytesParsed += static_cast<size_t>(bounds[r + 1] - bounds[r]);
+
+        // Progress_abstract is not thread-safe; only the thread that called us reports
+#ifdef HAVE_OPENMP
+        const bool reporter = omp_get_thread_num() == 0;
+#else
+        const bool reporter = true;
+#endif
+        if (progress && reporter && size > 0) {
+            uint32_t percent = static_cast<uint32_t>((done * 100ULL) / size);
             if (percent != lastPercent) {
                 lastPercent = percent;
-                float progressValue = percent / 100.0f;
                 progress->setMessage("Reading file...");
-                progress->setProgress(progressValue);
+                progress->setProgress(percent / 100.0f);
+            }
+            if (progress->isCancelled()) {
+                cancelled = true;
             }
         }
     }
-    
+    if (cancelled) {
+        return nullptr;
+    }
+
+    // Concatenate ranges in file order
+    std::vector<size_t> rangeOffsets(numRanges + 1, 0);
+    for (size_t r = 0; r < numRanges; ++r) {
+        rangeOffsets[r + 1] = rangeOffsets[r] + rangeVertices[r].size();
+    }
+    mesh->vertices.resize(rangeOffsets[numRanges]);
+    mesh->facets.resizeTriangles(rangeOffsets[numRanges] / 3);
+
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) if (numRanges > 1)
+#endif
+    for (long long r = 0; r < static_cast<long long>(numRanges); ++r) {
+        std::copy(rangeVertices[r].begin(), rangeVertices[r].end(), mesh->vertices.begin() + rangeOffsets[r]);
+        for (size_t v = rangeOffsets[r]; v < rangeOffsets[r + 1]; v += 3) {
+            // Create a triangular facet with flipped winding order
+            unsigned int baseIndex = static_cast<unsigned int>(v);
+            unsigned int* facet = mesh->facets.indices.data() + v;
+            facet[0] = baseIndex;
+            facet[1] = baseIndex + 2;
+            facet[2] = baseIndex + 1;
+        }
+        std::vector<Vertex>().swap(rangeVertices[r]);
+    }
+
     if (progress) {
         progress->setMessage("Processing geometry...");
         progress->setProgress(1.0f);
     }
-    
+
     mesh->calculateBounds();
-    
+
     return mesh;
 }
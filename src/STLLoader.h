@@ -3,6 +3,7 @@
 #include "Mesh.h"
 #include <string>
 #include <memory>
+#include <cstdint>
 
 // Forward declaration - can be Progress_abstract (global) or gui::Progress_abstract
 class Progress_abstract;
@@ -18,4 +19,9 @@ private:
     static std::unique_ptr<Mesh> loadBinary(const std::string& filename, Progress_abstract* progress);
     static std::unique_ptr<Mesh> loadASCII(const std::string& filename, Progress_abstract* progress);
     static bool isBinarySTL(const std::string& filename);
+    // Decode `count` consecutive 50-byte binary records into a presized mesh,
+    // starting at triangle index `firstTriangle`
+    static void decodeBinaryTriangles(const char* records, uint32_t firstTriangle, uint32_t count, Mesh& mesh);
+    // Same as decodeBinaryTriangles, split into chunks across OpenMP threads when available
+    static void decodeBinaryTrianglesParallel(const char* records, uint32_t firstTriangle, uint32_t count, Mesh& mesh);
 };
@@ -0,0 +1,391 @@
+#include "ScreenProjector.h"
+#include <algorithm>
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+// SSE2 is part of x86-64, so it is the baseline there
+#if defined(__x86_64__) || defined(_M_X64)
+#define SCREEN_PROJECTOR_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX instructions in functions marked for them;
+// MSVC emits whatever intrinsics it is given
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+namespace {
+
+using Nearest = ScreenProjector::Nearest;
+
+// rotated = (dot(rotateX, p), dot(rotateY, p)) for a model position p,
+// pixel = scale * rotated + offset
+struct Transform {
+    float rotateX[3];
+    float rotateY[3];
+    float scaleX, scaleY;
+    float offsetX, offsetY;
+};
+
+// One kernel does both jobs. Rotate: read model positions (x, y, z) and
+// write the rotated ones. Otherwise: read the rotated positions. Either way
+// the nearest vertex on screen is searched.
+struct Arrays {
+    const float* x;
+    const float* y;
+    const float* z;
+    float* rotatedX;
+    float* rotatedY;
+};
+
+// Lower distance wins, then lower index, so the result is the same for every
+// kernel and chunking
+inline void merge(Nearest& best, float distance2, size_t vertex) {
+    if (!(distance2 < std::numeric_limits<float>::infinity())) return; // unused lane
+    if (distance2 < best.distance2 || (distance2 == best.distance2 && vertex < best.vertex)) {
+        best.distance2 = distance2;
+        best.vertex = vertex;
+    }
+}
+
+template <bool Rotate>
+Nearest kernelScalar(const Arrays& a, size_t begin, size_t end, const Transform& m,
+                     float cursorX, float cursorY) {
+    Nearest best;
+    for (size_t i = begin; i < end; ++i) {
+        float rx, ry;
+        if (Rotate) {
+            rx = m.rotateX[0] * a.x[i] + m.rotateX[1] * a.y[i] + m.rotateX[2] * a.z[i];
+            ry = m.rotateY[0] * a.x[i] + m.rotateY[1] * a.y[i] + m.rotateY[2] * a.z[i];
+            a.rotatedX[i] = rx;
+            a.rotatedY[i] = ry;
+        } else {
+            rx = a.rotatedX[i];
+            ry = a.rotatedY[i];
+        }
+        const float sx = m.scaleX * rx + m.offsetX;
+        const float sy = m.scaleY * ry + m.offsetY;
+        const float dx = sx - cursorX;
+        const float dy = sy - cursorY;
+        merge(best, dx * dx + dy * dy, i);
+    }
+    return best;
+}
+
+#ifdef SCREEN_PROJECTOR_X86
+
+// Lane-wise minima, reduced with merge() at the end. Lane indices are 32-bit;
+// meshes index their vertices with unsigned int anyway.
+template <bool Rotate>
+Nearest kernelSSE2(const Arrays& a, size_t begin, size_t end, const Transform& m,
+                   float cursorX, float cursorY) {
+    const __m128 mx0 = _mm_set1_ps(m.rotateX[0]), mx1 = _mm_set1_ps(m.rotateX[1]), mx2 = _mm_set1_ps(m.rotateX[2]);
+    const __m128 my0 = _mm_set1_ps(m.rotateY[0]), my1 = _mm_set1_ps(m.rotateY[1]), my2 = _mm_set1_ps(m.rotateY[2]);
+    const __m128 scaleX = _mm_set1_ps(m.scaleX), scaleY = _mm_set1_ps(m.scaleY);
+    const __m128 offsetX = _mm_set1_ps(m.offsetX), offsetY = _mm_set1_ps(m.offsetY);
+    const __m128 cx = _mm_set1_ps(cursorX), cy = _mm_set1_ps(cursorY);
+    __m128 bestDistance = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    __m128i bestIndex = _mm_setzero_si128();
+    __m128i index = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(begin)), _mm_setr_epi32(0, 1, 2, 3));
+    const __m128i step = _mm_set1_epi32(4);
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 rx, ry;
+        if (Rotate) {
+            const __m128 px = _mm_loadu_ps(a.x + i), py = _mm_loadu_ps(a.y + i), pz = _mm_loadu_ps(a.z + i);
+            rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(mx0, px), _mm_mul_ps(mx1, py)), _mm_mul_ps(mx2, pz));
+            ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(my0, px), _mm_mul_ps(my1, py)), _mm_mul_ps(my2, pz));
+            _mm_storeu_ps(a.rotatedX + i, rx);
+            _mm_storeu_ps(a.rotatedY + i, ry);
+        } else {
+            rx = _mm_loadu_ps(a.rotatedX + i);
+            ry = _mm_loadu_ps(a.rotatedY + i);
+        }
+        const __m128 sx = _mm_add_ps(_mm_mul_ps(scaleX, rx), offsetX);
+        const __m128 sy = _mm_add_ps(_mm_mul_ps(scaleY, ry), offsetY);
+        const __m128 dx = _mm_sub_ps(sx, cx);
+        const __m128 dy = _mm_sub_ps(sy, cy);
+        const __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        const __m128 closer = _mm_cmplt_ps(distance, bestDistance);
+        bestDistance = _mm_or_ps(_mm_and_ps(closer, distance), _mm_andnot_ps(closer, bestDistance));
+        const __m128i closerIndex = _mm_castps_si128(closer);
+        bestIndex = _mm_or_si128(_mm_and_si128(closerIndex, index), _mm_andnot_si128(closerIndex, bestIndex));
+        index = _mm_add_epi32(index, step);
+    }
+    alignas(16) float distances[4];
+    alignas(16) unsigned int indices[4];
+    _mm_store_ps(distances, bestDistance);
+    _mm_store_si128(reinterpret_cast<__m128i*>(indices), bestIndex);
+    Nearest best = kernelScalar<Rotate>(a, i, end, m, cursorX, cursorY);
+    for (int lane = 0; lane < 4; ++lane) {
+        merge(best, distances[lane], indices[lane]);
+    }
+    return best;
+}
+
+template <bool Rotate>
+TARGET_AVX2 Nearest kernelAVX2(const Arrays& a, size_t begin, size_t end, const Transform& m,
+                               float cursorX, float cursorY) {
+    const __m256 mx0 = _mm256_set1_ps(m.rotateX[0]), mx1 = _mm256_set1_ps(m.rotateX[1]), mx2 = _mm256_set1_ps(m.rotateX[2]);
+    const __m256 my0 = _mm256_set1_ps(m.rotateY[0]), my1 = _mm256_set1_ps(m.rotateY[1]), my2 = _mm256_set1_ps(m.rotateY[2]);
+    const __m256 scaleX = _mm256_set1_ps(m.scaleX), scaleY = _mm256_set1_ps(m.scaleY);
+    const __m256 offsetX = _mm256_set1_ps(m.offsetX), offsetY = _mm256_set1_ps(m.offsetY);
+    const __m256 cx = _mm256_set1_ps(cursorX), cy = _mm256_set1_ps(cursorY);
+    __m256 bestDistance = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+    __m256i bestIndex = _mm256_setzero_si256();
+    __m256i index = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(begin)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    const __m256i step = _mm256_set1_epi32(8);
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 rx, ry;
+        if (Rotate) {
+            const __m256 px = _mm256_loadu_ps(a.x + i), py = _mm256_loadu_ps(a.y + i), pz = _mm256_loadu_ps(a.z + i);
+            rx = _mm256_fmadd_ps(mx0, px, _mm256_fmadd_ps(mx1, py, _mm256_mul_ps(mx2, pz)));
+            ry = _mm256_fmadd_ps(my0, px, _mm256_fmadd_ps(my1, py, _mm256_mul_ps(my2, pz)));
+            _mm256_storeu_ps(a.rotatedX + i, rx);
+            _mm256_storeu_ps(a.rotatedY + i, ry);
+        } else {
+            rx = _mm256_loadu_ps(a.rotatedX + i);
+            ry = _mm256_loadu_ps(a.rotatedY + i);
+        }
+        const __m256 sx = _mm256_fmadd_ps(scaleX, rx, offsetX);
+        const __m256 sy = _mm256_fmadd_ps(scaleY, ry, offsetY);
+        const __m256 dx = _mm256_sub_ps(sx, cx);
+        const __m256 dy = _mm256_sub_ps(sy, cy);
+        const __m256 distance = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+        const __m256 closer = _mm256_cmp_ps(distance, bestDistance, _CMP_LT_OQ);
+        bestDistance = _mm256_blendv_ps(bestDistance, distance, closer);
+        bestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIndex),
+                                                         _mm256_castsi256_ps(index), closer));
+        index = _mm256_add_epi32(index, step);
+    }
+    alignas(32) float distances[8];
+    alignas(32) unsigned int indices[8];
+    _mm256_store_ps(distances, bestDistance);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(indices), bestIndex);
+    Nearest best = kernelScalar<Rotate>(a, i, end, m, cursorX, cursorY);
+    for (int lane = 0; lane < 8; ++lane) {
+        merge(best, distances[lane], indices[lane]);
+    }
+    return best;
+}
+
+template <bool Rotate>
+TARGET_AVX512 Nearest kernelAVX512(const Arrays& a, size_t begin, size_t end, const Transform& m,
+                                   float cursorX, float cursorY) {
+    const __m512 mx0 = _mm512_set1_ps(m.rotateX[0]), mx1 = _mm512_set1_ps(m.rotateX[1]), mx2 = _mm512_set1_ps(m.rotateX[2]);
+    const __m512 my0 = _mm512_set1_ps(m.rotateY[0]), my1 = _mm512_set1_ps(m.rotateY[1]), my2 = _mm512_set1_ps(m.rotateY[2]);
+    const __m512 scaleX = _mm512_set1_ps(m.scaleX), scaleY = _mm512_set1_ps(m.scaleY);
+    const __m512 offsetX = _mm512_set1_ps(m.offsetX), offsetY = _mm512_set1_ps(m.offsetY);
+    const __m512 cx = _mm512_set1_ps(cursorX), cy = _mm512_set1_ps(cursorY);
+    __m512 bestDistance = _mm512_set1_ps(std::numeric_limits<float>::infinity());
+    __m512i bestIndex = _mm512_setzero_si512();
+    __m512i index = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(begin)),
+                                     _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    const __m512i step = _mm512_set1_epi32(16);
+    size_t i = begin;
+    for (; i + 16 <= end; i += 16) {
+        __m512 rx, ry;
+        if (Rotate) {
+            const __m512 px = _mm512_loadu_ps(a.x + i), py = _mm512_loadu_ps(a.y + i), pz = _mm512_loadu_ps(a.z + i);
+            rx = _mm512_fmadd_ps(mx0, px, _mm512_fmadd_ps(mx1, py, _mm512_mul_ps(mx2, pz)));
+            ry = _mm512_fmadd_ps(my0, px, _mm512_fmadd_ps(my1, py, _mm512_mul_ps(my2, pz)));
+            _mm512_storeu_ps(a.rotatedX + i, rx);
+            _mm512_storeu_ps(a.rotatedY + i, ry);
+        } else {
+            rx = _mm512_loadu_ps(a.rotatedX + i);
+            ry = _mm512_loadu_ps(a.rotatedY + i);
+        }
+        const __m512 sx = _mm512_fmadd_ps(scaleX, rx, offsetX);
+        const __m512 sy = _mm512_fmadd_ps(scaleY, ry, offsetY);
+        const __m512 dx = _mm512_sub_ps(sx, cx);
+        const __m512 dy = _mm512_sub_ps(sy, cy);
+        const __m512 distance = _mm512_fmadd_ps(dx, dx, _mm512_mul_ps(dy, dy));
+        const __mmask16 closer = _mm512_cmp_ps_mask(distance, bestDistance, _CMP_LT_OQ);
+        bestDistance = _mm512_mask_blend_ps(closer, bestDistance, distance);
+        bestIndex = _mm512_mask_blend_epi32(closer, bestIndex, index);
+        index = _mm512_add_epi32(index, step);
+    }
+    alignas(64) float distances[16];
+    alignas(64) unsigned int indices[16];
+    _mm512_store_ps(distances, bestDistance);
+    _mm512_store_si512(indices, bestIndex);
+    Nearest best = kernelScalar<Rotate>(a, i, end, m, cursorX, cursorY);
+    for (int lane = 0; lane < 16; ++lane) {
+        merge(best, distances[lane], indices[lane]);
+    }
+    return best;
+}
+
+enum class InstructionSet { Scalar, SSE2, AVX2, AVX512 };
+
+InstructionSet detectInstructionSet() {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return InstructionSet::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return InstructionSet::AVX2;
+    return InstructionSet::SSE2;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (maxLeaf < 7 || !osxsave) return InstructionSet::SSE2;
+    // The OS must save the YMM (and for AVX-512 the ZMM) registers
+    const unsigned long long xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] & (1 << 5)) != 0;
+    const bool avx512f = (info[1] & (1 << 16)) != 0;
+    if (avx512f && (xcr0 & 0xe6) == 0xe6) return InstructionSet::AVX512;
+    if (avx2 && fma && (xcr0 & 0x6) == 0x6) return InstructionSet::AVX2;
+    return InstructionSet::SSE2;
+#else
+    return InstructionSet::SSE2;
+#endif
+}
+
+#else
+
+enum class InstructionSet { Scalar };
+
+InstructionSet detectInstructionSet() { return InstructionSet::Scalar; }
+
+#endif // SCREEN_PROJECTOR_X86
+
+InstructionSet instructionSetInUse() {
+    static const InstructionSet isa = detectInstructionSet();
+    return isa;
+}
+
+template <bool Rotate>
+Nearest runKernel(const Arrays& a, size_t begin, size_t end, const Transform& m,
+                  float cursorX, float cursorY) {
+    switch (instructionSetInUse()) {
+#ifdef SCREEN_PROJECTOR_X86
+        case InstructionSet::AVX512: return kernelAVX512<Rotate>(a, begin, end, m, cursorX, cursorY);
+        case InstructionSet::AVX2: return kernelAVX2<Rotate>(a, begin, end, m, cursorX, cursorY);
+        case InstructionSet::SSE2: return kernelSSE2<Rotate>(a, begin, end, m, cursorX, cursorY);
+#endif
+        default: return kernelScalar<Rotate>(a, begin, end, m, cursorX, cursorY);
+    }
+}
+
+// Split [0, count) into one chunk per thread, run the kernel on each and keep
+// the best result
+template <bool Rotate>
+Nearest runChunked(const Arrays& a, size_t count, const Transform& m, const glm::vec2& cursor,
+                   bool parallel) {
+    size_t chunks = 1;
+#ifdef HAVE_OPENMP
+    if (parallel && count > 100000) chunks = static_cast<size_t>(omp_get_max_threads());
+#endif
+    (void)parallel;
+    std::vector<Nearest> results(chunks);
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(static, 1) if (chunks > 1)
+#endif
+    for (long long c = 0; c < static_cast<long long>(chunks); ++c) {
+        // Chunk bounds on multiples of 16 floats keep every chunk's vector loop
+        // on whole cache lines
+        const size_t chunk = static_cast<size_t>(c);
+        const size_t begin = (count * chunk / chunks) & ~size_t(15);
+        const size_t end = chunk + 1 == chunks ? count : (count * (chunk + 1) / chunks) & ~size_t(15);
+        results[c] = runKernel<Rotate>(a, begin, end, m, cursor.x, cursor.y);
+    }
+    Nearest best;
+    for (const Nearest& r : results) {
+        merge(best, r.distance2, r.vertex);
+    }
+    return best;
+}
+
+} // namespace
+
+void ScreenProjector::setMesh(const Mesh& mesh) {
+    const size_t count = mesh.vertices.size();
+    m_x.resize(count);
+    m_y.resize(count);
+    m_z.resize(count);
+    m_rotatedX.resize(count);
+    m_rotatedY.resize(count);
+    m_rotated = false;
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(static) if (count > 300000)
+#endif
+    for (long long i = 0; i < static_cast<long long>(count); ++i) {
+        const glm::vec3& p = mesh.vertices[i].position;
+        m_x[i] = p.x;
+        m_y[i] = p.y;
+        m_z[i] = p.z;
+    }
+}
+
+void ScreenProjector::clear() {
+    std::vector<float>().swap(m_x);
+    std::vector<float>().swap(m_y);
+    std::vector<float>().swap(m_z);
+    std::vector<float>().swap(m_rotatedX);
+    std::vector<float>().swap(m_rotatedY);
+    m_rotated = false;
+}
+
+ScreenProjector::Nearest ScreenProjector::nearest(const glm::mat4& mvp, const glm::mat3& rotation, int width,
+                                                  int height, const glm::vec2& cursor, bool parallel) {
+    // pixel x = (ndc.x * 0.5 + 0.5) * width, pixel y = (0.5 - ndc.y * 0.5) * height,
+    // with ndc = clip because w = 1 for an orthographic mvp. Its linear part
+    // is scale * rotation row by row, so the scale is the projection of each
+    // row onto the (unit) rotation row.
+    const float halfWidth = 0.5f * static_cast<float>(width);
+    const float halfHeight = 0.5f * static_cast<float>(height);
+    const glm::vec3 rowX(rotation[0][0], rotation[1][0], rotation[2][0]);
+    const glm::vec3 rowY(rotation[0][1], rotation[1][1], rotation[2][1]);
+    Transform transform;
+    for (int a = 0; a < 3; ++a) {
+        transform.rotateX[a] = rowX[a];
+        transform.rotateY[a] = rowY[a];
+    }
+    transform.scaleX = halfWidth * glm::dot(glm::vec3(mvp[0][0], mvp[1][0], mvp[2][0]), rowX);
+    transform.scaleY = -halfHeight * glm::dot(glm::vec3(mvp[0][1], mvp[1][1], mvp[2][1]), rowY);
+    transform.offsetX = halfWidth * mvp[3][0] + halfWidth;
+    transform.offsetY = -halfHeight * mvp[3][1] + halfHeight;
+
+    const Arrays arrays{m_x.data(), m_y.data(), m_z.data(), m_rotatedX.data(), m_rotatedY.data()};
+    if (isRotatedBy(rotation)) {
+        return runChunked<false>(arrays, m_x.size(), transform, cursor, parallel);
+    }
+    const Nearest result = runChunked<true>(arrays, m_x.size(), transform, cursor, parallel);
+    m_rotation = rotation;
+    m_rotated = true;
+    return result;
+}
+
+bool ScreenProjector::rotate(const glm::mat3& rotation, bool parallel) {
+    if (isRotatedBy(rotation)) {
+        return false;
+    }
+    // Any screen mapping does; only the rotated positions are kept
+    nearest(glm::mat4(1.0f), rotation, 1, 1, glm::vec2(0.0f), parallel);
+    return true;
+}
+
+const char* ScreenProjector::instructionSet() {
+    switch (instructionSetInUse()) {
+#ifdef SCREEN_PROJECTOR_X86
+        case InstructionSet::AVX512: return "AVX-512";
+        case InstructionSet::AVX2: return "AVX2";
+        case InstructionSet::SSE2: return "SSE2";
+#endif
+        default: return "scalar";
+    }
+}
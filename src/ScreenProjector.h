@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Mesh.h"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+// Screen-space picking of the mesh vertex nearest to the cursor.
+// With an orthographic camera that does not rotate, every vertex lands on
+// screen at scale * (rotation * position).xy + offset, where only the model
+// rotation needs a pass over the mesh. The projector therefore caches the
+// rotated x and y of every vertex and rebuilds them only when the rotation
+// (or the mesh) changes; pan, zoom, pivot and window size just change the
+// scale and offset, which are applied while searching.
+// Positions are kept per axis (x[], y[], z[]) so both passes run as SIMD
+// kernels: AVX-512 or AVX2 when the CPU has them (checked at run time),
+// SSE2 otherwise, plain C++ on other architectures. A rebuild finds the
+// nearest vertex in the same pass.
+class ScreenProjector {
+public:
+    struct Nearest {
+        size_t vertex = std::numeric_limits<size_t>::max(); // max: no vertices
+        float distance2 = std::numeric_limits<float>::infinity(); // squared, in pixels
+    };
+
+    // Copy the vertex positions; nothing is rotated until the first query
+    void setMesh(const Mesh& mesh);
+    void clear();
+    bool empty() const { return m_x.empty(); }
+
+    // Vertex nearest to `cursor`, in pixels of a width x height viewport
+    // (origin top left, y down). `mvp` maps model space to clip space; its
+    // upper 3x3 must be a scaling of x and y times `rotation`, which holds for
+    // glm::ortho * (translation) * model when `rotation` is the model's
+    // rotation. Rotates the cached positions first if `rotation` changed.
+    Nearest nearest(const glm::mat4& mvp, const glm::mat3& rotation, int width, int height,
+                    const glm::vec2& cursor, bool parallel);
+
+    // Rotate the cached positions ahead of the next query; returns false if
+    // they already were
+    bool rotate(const glm::mat3& rotation, bool parallel);
+
+    // Whether the cached positions are rotated by `rotation`, so that a query
+    // only searches
+    bool isRotatedBy(const glm::mat3& rotation) const { return m_rotated && m_rotation == rotation; }
+
+    size_t vertexCount() const { return m_x.size(); }
+
+    // Kernel in use: "AVX-512", "AVX2", "SSE2" or "scalar"
+    static const char* instructionSet();
+
+private:
+    std::vector<float> m_x, m_y, m_z;
+    std::vector<float> m_rotatedX, m_rotatedY;
+    glm::mat3 m_rotation{1.0f};
+    bool m_rotated = false;
+};
@@ -0,0 +1,375 @@
+#include "ThumbnailRenderer.h"
+#include "BoundedQueue.h"
+#include "progress/Progress_abstract.h"  // Include for mySTLviewer standalone compilation
+#include <glm/gtc/matrix_transform.hpp>
+#include <png.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+// Multisample resolve against a transparent background leaves edge pixels
+// with their color scaled by coverage; PNG wants it unscaled
+void unpremultiply(std::vector<unsigned char>& rgba) {
+    for (size_t i = 0; i + 3 < rgba.size(); i += 4) {
+        const unsigned int alpha = rgba[i + 3];
+        if (alpha == 0 || alpha == 255) continue;
+        for (int c = 0; c < 3; ++c) {
+            rgba[i + c] = static_cast<unsigned char>(std::min(255u, (rgba[i + c] * 255u + alpha / 2) / alpha));
+        }
+    }
+}
+
+// Comparison key for output names: case-folded, since Windows and macOS file
+// systems would let "Part.stl.png" overwrite "part.stl.png"
+std::string nameKey(const std::string& name) {
+    std::string key = name;
+    for (char& c : key) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return key;
+}
+
+// One output file name per input: "<file name>.png", or, where several inputs
+// share a file name (a/part.stl, b/part.stl), "<file name>-<position in the
+// list>.png" for all of them, so no thumbnail overwrites another
+std::vector<std::string> outputNames(const std::vector<std::string>& files) {
+    std::vector<std::string> names(files.size());
+    std::unordered_map<std::string, size_t> count;
+    for (size_t i = 0; i < files.size(); ++i) {
+        names[i] = std::filesystem::path(files[i]).filename().string();
+        ++count[nameKey(names[i])];
+    }
+    std::unordered_set<std::string> taken;
+    for (const std::string& name : names) {
+        if (count[nameKey(name)] == 1) taken.insert(nameKey(name + ".png"));
+    }
+    size_t renamed = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (count[nameKey(names[i])] == 1) {
+            names[i] += ".png";
+            continue;
+        }
+        // The suffix could still hit an input actually called "part.stl-2"
+        std::string name;
+        for (size_t n = i + 1;; n += files.size()) {
+            name = names[i] + "-" + std::to_string(n) + ".png";
+            if (taken.insert(nameKey(name)).second) break;
+        }
+        names[i] = name;
+        ++renamed;
+    }
+    if (renamed > 0) {
+        std::cerr << "Warning: " << renamed << " input files share their file name with another; their thumbnails "
+                  << "are numbered by position in the list" << std::endl;
+    }
+    return names;
+}
+
+} // namespace
+
+ThumbnailRenderer::~ThumbnailRenderer() {
+    deleteTargets();
+}
+
+bool ThumbnailRenderer::initialize(const ThumbnailOptions& options) {
+    m_options = options;
+    m_options.width = std::max(1, m_options.width);
+    m_options.height = std::max(1, m_options.height);
+    const int width = m_options.width;
+    const int height = m_options.height;
+
+    GLint maxSize = 0, maxSamples = 0;
+    glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxSize);
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    if (width > maxSize || height > maxSize) {
+        std::cerr << "Thumbnail size " << width << "x" << height << " exceeds the GL limit of " << maxSize
+                  << " pixels" << std::endl;
+        return false;
+    }
+    const int samples = std::min(std::max(0, m_options.samples), static_cast<int>(maxSamples));
+
+    if (!m_renderer.initialize()) {
+        std::cerr << "Failed to initialize renderer" << std::endl;
+        return false;
+    }
+    m_renderer.setDrawSolid(m_options.drawSolid);
+    m_renderer.setDrawWireframe(m_options.drawWireframe);
+    m_renderer.setFeatureEdgesOnly(m_options.featureEdgesOnly);
+
+    glGenRenderbuffers(1, &m_multisampleColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_multisampleColor);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &m_multisampleDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_multisampleDepth);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, width, height);
+    glGenRenderbuffers(1, &m_resolveColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_resolveColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_multisampleFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_multisampleFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_multisampleColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_multisampleDepth);
+    const GLenum multisampleStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glGenFramebuffers(1, &m_resolveFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_resolveFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_resolveColor);
+    const GLenum resolveStatus = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (multisampleStatus != GL_FRAMEBUFFER_COMPLETE || resolveStatus != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Thumbnail framebuffer incomplete: 0x" << std::hex << multisampleStatus << ", 0x"
+                  << resolveStatus << std::dec << std::endl;
+        deleteTargets();
+        return false;
+    }
+
+    for (Readback& readback : m_readbacks) {
+        glGenBuffers(1, &readback.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size_t(width) * height * 4, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // The state the viewer sets up once for its window
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glEnable(GL_MULTISAMPLE);
+    glDisable(GL_DITHER);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    return true;
+}
+
+size_t ThumbnailRenderer::renderFiles(const std::vector<std::string>& files, const GeometryLoadOptions& loadOptions,
+                                      const MeshRenderOptions& renderOptions, Progress_abstract* progress) {
+    if (files.empty() || !m_resolveFBO) {
+        return 0;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(m_options.outputDirectory, ec);
+    if (ec) {
+        std::cerr << "Cannot create output directory " << m_options.outputDirectory << ": " << ec.message()
+                  << std::endl;
+        return 0;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<std::string> names = outputNames(files);
+
+    MeshRenderOptions meshOptions = renderOptions;
+    meshOptions.levelOfDetail = false;
+
+    // Loaders: parse, weld, triangulate and build the render buffers of one file
+    // each at a time. The queue holds at most one prepared mesh per loader, which
+    // bounds memory however long the file list is.
+    const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned int loaderCount = static_cast<unsigned int>(std::min<size_t>(
+        m_options.loaderThreads > 0 ? m_options.loaderThreads : cores, files.size()));
+    struct Loaded {
+        size_t file = 0;
+        std::unique_ptr<MeshRenderData> data; // nullptr: the file failed to load
+    };
+    BoundedQueue<Loaded> loaded(loaderCount);
+    std::atomic<size_t> nextFile{0};
+    std::vector<std::thread> loaders;
+    for (unsigned int t = 0; t < loaderCount; ++t) {
+        loaders.emplace_back([&] {
+#ifdef HAVE_OPENMP
+            // The parallel loops inside a load share the cores with the other loaders
+            omp_set_num_threads(static_cast<int>(std::max(1u, cores / loaderCount)));
+#endif
+            for (size_t i = nextFile++; i < files.size(); i = nextFile++) {
+                Loaded item;
+                item.file = i;
+                std::unique_ptr<Mesh> mesh = GeometryLoader::load(files[i], loadOptions);
+                if (mesh) {
+                    item.data = Renderer::prepareMesh(std::move(mesh), meshOptions);
+                }
+                if (!loaded.push(std::move(item))) {
+                    return;
+                }
+            }
+        });
+    }
+
+    // PNG compression takes longer than drawing a typical mesh, so it gets its own thread
+    struct Image {
+        std::string path;
+        std::vector<unsigned char> rgba;
+    };
+    BoundedQueue<Image> images(4);
+    std::atomic<size_t> written{0};
+    std::thread writer([&] {
+        Image image;
+        while (images.pop(image)) {
+            unpremultiply(image.rgba);
+            if (writePNG(image.path, m_options.width, m_options.height, image.rgba)) {
+                ++written;
+            }
+        }
+    });
+
+    if (progress) {
+        progress->setMessage("Rendering thumbnails...");
+    }
+    // Each image is copied into one pixel buffer while the next mesh is
+    // uploaded and drawn, and collected from the other buffer after that
+    size_t slot = 0;
+    auto collect = [&](Readback& readback) {
+        Image image;
+        if (finishReadback(readback, image.rgba)) {
+            image.path = readback.path;
+            images.push(std::move(image));
+        }
+    };
+    for (size_t done = 0; done < files.size(); ++done) {
+        Loaded item;
+        if (!loaded.pop(item)) {
+            break;
+        }
+        const std::string& path = files[item.file];
+        if (!item.data) {
+            std::cerr << "Failed to load file: " << path << std::endl;
+        } else {
+            m_renderer.setPreparedMesh(std::move(item.data));
+            renderMesh();
+            startReadback(m_readbacks[slot],
+                          (std::filesystem::path(m_options.outputDirectory) / names[item.file]).string());
+            slot ^= 1;
+            collect(m_readbacks[slot]);
+        }
+        if (progress) {
+            progress->setProgress(static_cast<float>(done + 1) / static_cast<float>(files.size()));
+        }
+    }
+    collect(m_readbacks[slot ^ 1]);
+
+    loaded.close();
+    for (std::thread& loader : loaders) {
+        loader.join();
+    }
+    images.close();
+    writer.join();
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Wrote " << written << " of " << files.size() << " thumbnails in " << seconds << " s ("
+              << (seconds > 0.0 ? files.size() / seconds : 0.0) << " files/s, " << loaderCount << " loader threads)"
+              << std::endl;
+    return written;
+}
+
+void ThumbnailRenderer::renderMesh() {
+    const int width = m_options.width;
+    const int height = m_options.height;
+    glBindFramebuffer(GL_FRAMEBUFFER, m_multisampleFBO);
+    glViewport(0, 0, width, height);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    const Mesh* mesh = m_renderer.getMesh();
+    if (mesh) {
+        // Orthographic like the viewer, framing the bounding sphere so that no
+        // rotation can push the mesh out of the picture
+        const float aspect = static_cast<float>(width) / static_cast<float>(height);
+        const float radius = std::max(0.5f * glm::length(mesh->max_bounds - mesh->min_bounds), 1e-6f);
+        const float halfHeight = radius * 1.05f / std::min(1.0f, aspect);
+        const glm::mat4 projection = glm::ortho(-halfHeight * aspect, halfHeight * aspect, -halfHeight, halfHeight,
+                                                -2.0f * radius, 2.0f * radius);
+        glm::mat4 model(1.0f);
+        model = glm::rotate(model, glm::radians(m_options.rotationX), glm::vec3(1.0f, 0.0f, 0.0f));
+        model = glm::rotate(model, glm::radians(m_options.rotationY), glm::vec3(0.0f, 1.0f, 0.0f));
+        model = glm::translate(model, -mesh->getCenter());
+        m_renderer.setViewportSize(width, height);
+        m_renderer.render(projection, glm::mat4(1.0f), model);
+    }
+
+    // Resolve the samples into the buffer that is read back
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_multisampleFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_resolveFBO);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ThumbnailRenderer::startReadback(Readback& readback, const std::string& path) {
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_resolveFBO);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_options.width, m_options.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    if (readback.fence) {
+        glDeleteSync(readback.fence);
+    }
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush(); // start the copy now rather than at the next wait
+    readback.path = path;
+}
+
+bool ThumbnailRenderer::finishReadback(Readback& readback, std::vector<unsigned char>& rgba) {
+    if (!readback.fence) {
+        return false;
+    }
+    GLenum status;
+    do {
+        status = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+    } while (status == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+    if (status == GL_WAIT_FAILED) {
+        std::cerr << "Read-back failed for " << readback.path << std::endl;
+        return false;
+    }
+
+    const size_t bytes = size_t(m_options.width) * m_options.height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+    if (pixels) {
+        rgba.resize(bytes);
+        std::memcpy(rgba.data(), pixels, bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return pixels != nullptr;
+}
+
+void ThumbnailRenderer::deleteTargets() {
+    for (Readback& readback : m_readbacks) {
+        if (readback.fence) glDeleteSync(readback.fence);
+        if (readback.buffer) glDeleteBuffers(1, &readback.buffer);
+        readback = Readback();
+    }
+    if (m_multisampleFBO) glDeleteFramebuffers(1, &m_multisampleFBO);
+    if (m_resolveFBO) glDeleteFramebuffers(1, &m_resolveFBO);
+    if (m_multisampleColor) glDeleteRenderbuffers(1, &m_multisampleColor);
+    if (m_multisampleDepth) glDeleteRenderbuffers(1, &m_multisampleDepth);
+    if (m_resolveColor) glDeleteRenderbuffers(1, &m_resolveColor);
+    m_multisampleFBO = m_resolveFBO = m_multisampleColor = m_multisampleDepth = m_resolveColor = 0;
+}
+
+bool ThumbnailRenderer::writePNG(const std::string& path, int width, int height,
+                                 const std::vector<unsigned char>& rgba) {
+    if (width <= 0 || height <= 0 || rgba.size() < size_t(width) * height * 4) {
+        return false;
+    }
+    png_image image;
+    std::memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    image.width = static_cast<png_uint_32>(width);
+    image.height = static_cast<png_uint_32>(height);
+    image.format = PNG_FORMAT_RGBA;
+    // A negative row stride tells libpng the rows are stored bottom up
+    if (!png_image_write_to_file(&image, path.c_str(), 0, rgba.data(), -width * 4, nullptr)) {
+        std::cerr << "Failed to write " << path << ": " << image.message << std::endl;
+        return false;
+    }
+    return true;
+}
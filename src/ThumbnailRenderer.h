@@ -0,0 +1,78 @@
+#pragma once
+
+#include "GeometryLoader.h"
+#include "Renderer.h"
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+
+// Forward declaration - can be Progress_abstract (global) or gui::Progress_abstract
+class Progress_abstract;
+
+struct ThumbnailOptions {
+    int width = 512;
+    int height = 512;
+    // Camera: the viewer's rotation angles in degrees (the defaults are its
+    // start view), the whole mesh framed, light from above
+    float rotationX = 30.0f;
+    float rotationY = 45.0f;
+    bool drawSolid = true;
+    bool drawWireframe = false;
+    bool featureEdgesOnly = false;
+    int samples = 4;                      // multisampling; clamped to what the GL offers
+    std::string outputDirectory = ".";
+    unsigned int loaderThreads = 0;       // 0: one per core, at most one per file
+};
+
+// Batch preview rendering without a window: loads geometry files on worker
+// threads and feeds them to a single GL context (current on the calling
+// thread, see OffscreenContext), which draws each with the Renderer's solid
+// and wireframe passes into a multisampled framebuffer and reads it back
+// through pixel buffer objects, one frame behind so the GPU copy overlaps
+// with the next mesh. A separate thread writes the PNGs (transparent
+// background, straight alpha).
+class ThumbnailRenderer {
+public:
+    ThumbnailRenderer() = default;
+    ~ThumbnailRenderer();
+
+    ThumbnailRenderer(const ThumbnailRenderer&) = delete;
+    ThumbnailRenderer& operator=(const ThumbnailRenderer&) = delete;
+
+    // Shaders and framebuffers; needs the current GL context. Returns false on failure.
+    bool initialize(const ThumbnailOptions& options);
+
+    // Render <outputDirectory>/<file name>.png for every file (file names that
+    // occur more than once in the list get "-<position>" before ".png");
+    // returns how many were written. Files that fail to load are reported and skipped.
+    // No levels of detail are built, whatever renderOptions says: every mesh is drawn once.
+    size_t renderFiles(const std::vector<std::string>& files, const GeometryLoadOptions& loadOptions,
+                       const MeshRenderOptions& renderOptions, Progress_abstract* progress = nullptr);
+
+    void setDebugValidation(bool enabled) { m_renderer.setDebugValidation(enabled); }
+
+    // Write rows of RGBA8 pixels, bottom row first (as glReadPixels returns them)
+    static bool writePNG(const std::string& path, int width, int height, const std::vector<unsigned char>& rgba);
+
+private:
+    // One pixel buffer object in the read-back ring
+    struct Readback {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+        std::string path; // where the image goes
+    };
+
+    void renderMesh();
+    void startReadback(Readback& readback, const std::string& path);
+    bool finishReadback(Readback& readback, std::vector<unsigned char>& rgba);
+    void deleteTargets();
+
+    ThumbnailOptions m_options;
+    Renderer m_renderer;
+    GLuint m_multisampleFBO = 0;   // drawn into
+    GLuint m_multisampleColor = 0;
+    GLuint m_multisampleDepth = 0;
+    GLuint m_resolveFBO = 0;       // single-sample copy that is read back
+    GLuint m_resolveColor = 0;
+    Readback m_readbacks[2];
+};
@@ -1,12 +1,116 @@
 #include "XMLLoader.h"
+#include "XMLStreamParser.h"
+#include "BoundedQueue.h"
+#include "MappedFile.h"
 #include "progress/Progress_abstract.h"  // Include for mySTLviewer standalone compilation
 #include <pugixml.hpp>
 #include <archive.h>
 #include <archive_entry.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
 #include <iostream>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 #include <cstring>
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+// Bytes handed to the streaming parser between progress updates (and per read without mmap)
+constexpr size_t kXMLBlockBytes = size_t(4) << 20;
+
+bool isCancelled(Progress_abstract* progress) {
+    return progress && progress->isCancelled();
+}
+
+// Streaming parse runs from `start` to 50% of the load, resolving facets 50-90%
+void reportParseProgress(Progress_abstract* progress, size_t done, size_t total, float start) {
+    if (progress && total > 0) {
+        const float fraction = std::min(1.0f, static_cast<float>(done) / static_cast<float>(total));
+        progress->setProgress(start + (0.5f - start) * fraction);
+    }
+}
+
+// Vertex ID -> vertex index. MolFlow numbers vertices densely from 0, so when the
+// IDs span a range not much larger than the vertex count they index a flat table
+// directly; only sparse IDs fall back to a hash map.
+class VertexIdMap {
+public:
+    static constexpr unsigned int kMissing = 0xFFFFFFFFu;
+    
+    explicit VertexIdMap(const std::vector<int>& ids) {
+        if (ids.empty()) {
+            return;
+        }
+        const auto range = std::minmax_element(ids.begin(), ids.end());
+        const int64_t span = static_cast<int64_t>(*range.second) - *range.first + 1;
+        m_dense = span <= static_cast<int64_t>(ids.size()) * 2 + 1024;
+        if (m_dense) {
+            m_base = *range.first;
+            m_table.assign(static_cast<size_t>(span), kMissing);
+            for (size_t i = 0; i < ids.size(); ++i) {
+                m_table[static_cast<size_t>(static_cast<int64_t>(ids[i]) - m_base)] = static_cast<unsigned int>(i);
+            }
+        } else {
+            m_map.reserve(ids.size());
+            for (size_t i = 0; i < ids.size(); ++i) {
+                m_map[ids[i]] = static_cast<unsigned int>(i);
+            }
+        }
+    }
+    
+    unsigned int find(int id) const {
+        if (m_dense) {
+            const int64_t slot = static_cast<int64_t>(id) - m_base;
+            return (slot >= 0 && slot < static_cast<int64_t>(m_table.size())) ? m_table[static_cast<size_t>(slot)] : kMissing;
+        }
+        auto it = m_map.find(id);
+        return it != m_map.end() ? it->second : kMissing;
+    }
+    
+private:
+    bool m_dense = true;
+    int64_t m_base = 0;
+    std::vector<unsigned int> m_table;
+    std::unordered_map<int, unsigned int> m_map;
+};
+
+// Work unit handed to one thread when facet normals are computed in parallel
+constexpr size_t kFacetsPerChunk = 4096;
+
+// Facet normal using Newell's method (robust for non-planar polygons)
+glm::vec3 newellNormal(const FacetView& facet, const std::vector<glm::vec3>& positions) {
+    const size_t count = facet.size();
+    glm::vec3 normal(0.0f);
+    if (count >= 3) {
+        for (size_t i = 0; i < count; ++i) {
+            const glm::vec3& v1 = positions[facet[i]];
+            const glm::vec3& v2 = positions[facet[(i + 1) % count]];
+            
+            normal.x += (v1.y - v2.y) * (v1.z + v2.z);
+            normal.y += (v1.z - v2.z) * (v1.x + v2.x);
+            normal.z += (v1.x - v2.x) * (v1.y + v2.y);
+        }
+        
+        float length = glm::length(normal);
+        if (length > 0.0001f) {
+            normal = glm::normalize(normal);
+        } else {
+            // Fallback: use cross product of first two edges
+            glm::vec3 edge1 = positions[facet[1]] - positions[facet[0]];
+            glm::vec3 edge2 = positions[facet[2]] - positions[facet[0]];
+            normal = glm::normalize(glm::cross(edge1, edge2));
+        }
+    }
+    return normal;
+}
+
+} // namespace
 
 std::unique_ptr<Mesh> XMLLoader::load(const std::string& filename, Progress_abstract* progress) {
     // Check if it's a zip file
@@ -19,7 +123,16 @@ std::unique_ptr<Mesh> XMLLoader::load(const std::string& filename, Progress_abst
         progress->setProgress(0.1f);
     }
     
-    // Otherwise load as regular XML file
+    // Stream the geometry section without building a DOM of the whole document
+    XMLGeometry geometry;
+    if (streamXMLFile(filename, geometry, progress)) {
+        return buildMesh(geometry, progress);
+    }
+    if (isCancelled(progress)) {
+        return nullptr;
+    }
+    
+    // Fall back to loading the whole document with pugixml
     pugi::xml_document doc;
     pugi::xml_parse_result result = doc.load_file(filename.c_str());
     
@@ -32,148 +145,235 @@ std::unique_ptr<Mesh> XMLLoader::load(const std::string& filename, Progress_abst
     return loadFromXMLString(doc, progress);
 }
 
-std::unique_ptr<Mesh> XMLLoader::loadFromXMLString(const pugi::xml_document& doc, Progress_abstract* progress) {
-    auto mesh = std::make_unique<Mesh>();
+bool XMLLoader::streamXMLFile(const std::string& filename, XMLGeometry& geometry, Progress_abstract* progress) {
+    MappedFile mapped;
+    if (mapped.open(filename)) {
+        return streamXMLBuffer(mapped.data(), mapped.size(), geometry, progress);
+    }
     
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false; // Let the DOM parser report the error
+    }
+    const size_t fileSize = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+    
+    XMLStreamParser parser(geometry);
+    std::vector<char> block(kXMLBlockBytes);
+    size_t bytesRead = 0;
+    while (file) {
+        if (isCancelled(progress)) {
+            return false;
+        }
+        file.read(block.data(), block.size());
+        const size_t got = static_cast<size_t>(file.gcount());
+        if (got == 0 || !parser.feed(block.data(), got)) {
+            break;
+        }
+        bytesRead += got;
+        reportParseProgress(progress, bytesRead, fileSize, 0.1f);
+    }
+    
+    if (!parser.finish()) {
+        std::cerr << "Streaming XML parse failed (" << parser.error() << "), retrying with DOM parser" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool XMLLoader::streamXMLBuffer(const char* data, size_t size, XMLGeometry& geometry, Progress_abstract* progress) {
+    XMLStreamParser parser(geometry);
+    for (size_t offset = 0; offset < size; offset += kXMLBlockBytes) {
+        if (isCancelled(progress)) {
+            return false;
+        }
+        const size_t count = std::min(kXMLBlockBytes, size - offset);
+        if (!parser.feed(data + offset, count)) {
+            break;
+        }
+        reportParseProgress(progress, offset + count, size, 0.1f);
+    }
+    
+    if (!parser.finish()) {
+        std::cerr << "Streaming XML parse failed (" << parser.error() << "), retrying with DOM parser" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<Mesh> XMLLoader::loadFromXMLString(const pugi::xml_document& doc, Progress_abstract* progress) {
     if (progress) {
         progress->setMessage("Parsing geometry structure...");
         progress->setProgress(0.2f);
     }
     
-    // Navigate to Geometry node
-    pugi::xml_node geometry = doc.child("SimulationEnvironment").child("Geometry");
-    if (!geometry) {
+    // Collect the geometry section from the DOM; buildMesh reports missing nodes
+    XMLGeometry geometry;
+    pugi::xml_node geometry_node = doc.child("SimulationEnvironment").child("Geometry");
+    if (geometry_node) {
+        geometry.hasGeometry = true;
+        
+        pugi::xml_node vertices_node = geometry_node.child("Vertices");
+        if (vertices_node) {
+            geometry.hasVertices = true;
+            geometry.declaredVertices = vertices_node.attribute("nb").as_int();
+            int nb_vertices = geometry.declaredVertices;
+            
+            if (progress) {
+                progress->setMessage("Loading vertices...");
+                progress->setProgress(0.3f);
+            }
+            
+            int vertexCount = 0;
+            for (pugi::xml_node vertex : vertices_node.children("Vertex")) {
+                geometry.vertexIds.push_back(vertex.attribute("id").as_int());
+                geometry.positions.emplace_back(vertex.attribute("x").as_float(),
+                                                vertex.attribute("y").as_float(),
+                                                vertex.attribute("z").as_float());
+                vertexCount++;
+                
+                // Update progress for vertices (30-50% of total)
+                if (progress && nb_vertices > 0 && (vertexCount % 100 == 0 || vertexCount == nb_vertices)) {
+                    float vertexProgress = 0.3f + (vertexCount / static_cast<float>(nb_vertices)) * 0.2f;
+                    progress->setMessage("Loading vertices...");
+                    progress->setProgress(vertexProgress);
+                    if (progress->isCancelled()) {
+                        return nullptr;
+                    }
+                }
+            }
+        }
+        
+        pugi::xml_node facets_node = geometry_node.child("Facets");
+        if (facets_node) {
+            geometry.hasFacets = true;
+            geometry.declaredFacets = facets_node.attribute("nb").as_int();
+            for (pugi::xml_node facet : facets_node.children("Facet")) {
+                pugi::xml_node indices_node = facet.child("Indices");
+                if (!indices_node) {
+                    continue; // Skip facets without indices
+                }
+                for (pugi::xml_node indice : indices_node.children("Indice")) {
+                    geometry.facetVertexIds.push_back(indice.attribute("vertex").as_int());
+                }
+                geometry.facetOffsets.push_back(static_cast<unsigned int>(geometry.facetVertexIds.size()));
+            }
+        }
+    }
+    
+    if (isCancelled(progress)) {
+        return nullptr;
+    }
+    return buildMesh(geometry, progress);
+}
+
+std::unique_ptr<Mesh> XMLLoader::buildMesh(const XMLGeometry& geometry, Progress_abstract* progress) {
+    if (!geometry.hasGeometry) {
         std::cerr << "No Geometry node found in XML" << std::endl;
         return nullptr;
     }
-    
-    // Load vertices
-    pugi::xml_node vertices_node = geometry.child("Vertices");
-    if (!vertices_node) {
+    if (!geometry.hasVertices) {
         std::cerr << "No Vertices node found in XML" << std::endl;
         return nullptr;
     }
-    
-    int nb_vertices = vertices_node.attribute("nb").as_int();
-    
-    if (progress) {
-        progress->setMessage("Loading vertices...");
-        progress->setProgress(0.3f);
+    if (!geometry.hasFacets) {
+        std::cerr << "No Facets node found in XML" << std::endl;
+        return nullptr;
     }
     
-    // Reserve space for vertices
-    mesh->vertices.reserve(nb_vertices);
-    
-    // Map to keep track of vertex ID to index mapping
-    std::unordered_map<int, unsigned int> vertexIdToIndex;
+    auto mesh = std::make_unique<Mesh>();
     
-    // Parse vertices
-    int vertexCount = 0;
-    for (pugi::xml_node vertex : vertices_node.children("Vertex")) {
-        int id = vertex.attribute("id").as_int();
-        float x = vertex.attribute("x").as_float();
-        float y = vertex.attribute("y").as_float();
-        float z = vertex.attribute("z").as_float();
-        
-        Vertex v;
-        v.position = glm::vec3(x, y, z);
-        v.normal = glm::vec3(0.0f); // Will be computed per-facet
-        
-        vertexIdToIndex[id] = mesh->vertices.size();
-        mesh->vertices.push_back(v);
-        vertexCount++;
-        
-        // Update progress for vertices (30-50% of total)
-        if (progress && nb_vertices > 0 && (vertexCount % 100 == 0 || vertexCount == nb_vertices)) {
-            float vertexProgress = 0.3f + (vertexCount / static_cast<float>(nb_vertices)) * 0.2f;
-            progress->setMessage("Loading vertices...");
-            progress->setProgress(vertexProgress);
-        }
+    // Vertices keep file order; map vertex ID to index (a repeated ID refers to its last vertex)
+    const std::vector<glm::vec3>& positions = geometry.positions;
+    const size_t nb_vertices = positions.size();
+    mesh->vertices.resize(nb_vertices);
+    for (size_t i = 0; i < nb_vertices; ++i) {
+        mesh->vertices[i].position = positions[i];
+        mesh->vertices[i].normal = glm::vec3(0.0f); // Will be computed per-facet
     }
+    const VertexIdMap vertexIdToIndex(geometry.vertexIds);
     
     if (progress) {
         progress->setMessage("Loading facets...");
         progress->setProgress(0.5f);
     }
     
-    // Load facets
-    pugi::xml_node facets_node = geometry.child("Facets");
-    if (!facets_node) {
-        std::cerr << "No Facets node found in XML" << std::endl;
-        return nullptr;
+    // Resolve every vertex ID straight into the flat index array, in parallel
+    const size_t facetCount = geometry.facetCount();
+    const std::vector<int>& ids = geometry.facetVertexIds;
+    std::vector<unsigned int>& indices = mesh->facets.indices;
+    indices.resize(ids.size());
+    long long missing = 0;
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(static) reduction(+:missing)
+#endif
+    for (long long k = 0; k < static_cast<long long>(ids.size()); ++k) {
+        indices[k] = vertexIdToIndex.find(ids[k]);
+        missing += (indices[k] == VertexIdMap::kMissing);
     }
     
-    int nb_facets = facets_node.attribute("nb").as_int();
-    
-    mesh->facets.reserve(nb_facets);
-    
-    // Parse facets
-    int facetCount = 0;
-    for (pugi::xml_node facet : facets_node.children("Facet")) {
-        pugi::xml_node indices_node = facet.child("Indices");
-        if (!indices_node) {
-            continue; // Skip facets without indices
-        }
-        
-        Facet f;
-        int nb_indices = indices_node.attribute("nb").as_int();
-        f.indices.reserve(nb_indices);
-        
-        // Collect vertex indices for this facet
-        std::vector<glm::vec3> facetPositions;
-        for (pugi::xml_node indice : indices_node.children("Indice")) {
-            int vertexId = indice.attribute("vertex").as_int();
-            
-            // Map vertex ID to our internal index
-            auto it = vertexIdToIndex.find(vertexId);
-            if (it != vertexIdToIndex.end()) {
-                unsigned int vertexIndex = it->second;
-                f.indices.push_back(vertexIndex);
-                facetPositions.push_back(mesh->vertices[vertexIndex].position);
-            }
-        }
-        
-        // Compute facet normal using Newell's method (robust for non-planar polygons)
-        glm::vec3 normal(0.0f);
-        if (facetPositions.size() >= 3) {
-            for (size_t i = 0; i < facetPositions.size(); ++i) {
-                const glm::vec3& v1 = facetPositions[i];
-                const glm::vec3& v2 = facetPositions[(i + 1) % facetPositions.size()];
-                
-                normal.x += (v1.y - v2.y) * (v1.z + v2.z);
-                normal.y += (v1.z - v2.z) * (v1.x + v2.x);
-                normal.z += (v1.x - v2.x) * (v1.y + v2.y);
-            }
-            
-            float length = glm::length(normal);
-            if (length > 0.0001f) {
-                normal = glm::normalize(normal);
-            } else {
-                // Fallback: use cross product of first two edges
-                if (facetPositions.size() >= 3) {
-                    glm::vec3 edge1 = facetPositions[1] - facetPositions[0];
-                    glm::vec3 edge2 = facetPositions[2] - facetPositions[0];
-                    normal = glm::normalize(glm::cross(edge1, edge2));
+    if (missing == 0) {
+        mesh->facets.offsets = geometry.facetOffsets;
+    } else {
+        // Unknown IDs are dropped; compact the facets in order (rare, so serial)
+        std::vector<unsigned int>& offsets = mesh->facets.offsets;
+        offsets.assign(facetCount + 1, 0);
+        size_t out = 0;
+        for (size_t f = 0; f < facetCount; ++f) {
+            for (unsigned int k = geometry.facetOffsets[f]; k < geometry.facetOffsets[f + 1]; ++k) {
+                if (indices[k] != VertexIdMap::kMissing) {
+                    indices[out++] = indices[k];
                 }
             }
+            offsets[f + 1] = static_cast<unsigned int>(out);
         }
-        
-        // Assign the computed normal to all vertices in this facet
-        for (unsigned int idx : f.indices) {
-            mesh->vertices[idx].normal = normal;
+        indices.resize(out);
+    }
+    if (isCancelled(progress)) {
+        return nullptr;
+    }
+    
+    // Facet normals are independent of each other
+    std::vector<glm::vec3> facetNormals(facetCount);
+    const long long numChunks = (static_cast<long long>(facetCount) + kFacetsPerChunk - 1) / kFacetsPerChunk;
+    std::atomic<long long> chunksDone{0};
+#ifdef HAVE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 1) if (numChunks > 1)
+#endif
+    for (long long chunk = 0; chunk < numChunks; ++chunk) {
+        const size_t first = static_cast<size_t>(chunk) * kFacetsPerChunk;
+        const size_t last = std::min(facetCount, first + kFacetsPerChunk);
+        for (size_t f = first; f < last; ++f) {
+            facetNormals[f] = newellNormal(mesh->facets[f], positions);
         }
+        const long long done = ++chunksDone;
         
-        mesh->facets.push_back(f);
-        facetCount++;
-        
+        // Progress_abstract is not thread-safe; only the thread that called us reports
+#ifdef HAVE_OPENMP
+        const bool reporter = omp_get_thread_num() == 0;
+#else
+        const bool reporter = true;
+#endif
         // Update progress for facets (50-90% of total)
-        if (progress && nb_facets > 0 && (facetCount % 100 == 0 || facetCount == nb_facets)) {
-            float facetProgress = 0.5f + (facetCount / static_cast<float>(nb_facets)) * 0.4f;
+        if (progress && reporter) {
+            float facetProgress = 0.5f + (done / static_cast<float>(numChunks)) * 0.4f;
             progress->setMessage("Loading facets...");
             progress->setProgress(facetProgress);
         }
     }
     
+    if (isCancelled(progress)) {
+        return nullptr;
+    }
+    
+    // Assign the computed normal to all vertices of each facet. Runs in file order
+    // so a vertex shared by several facets keeps the normal of the last one.
+    for (size_t f = 0; f < facetCount; ++f) {
+        for (unsigned int idx : mesh->facets[f]) {
+            mesh->vertices[idx].normal = facetNormals[f];
+        }
+    }
+    
     if (progress) {
         progress->setMessage("Processing geometry...");
         progress->setProgress(0.9f);
@@ -208,12 +408,18 @@ bool XMLLoader::isZipFile(const std::string& filename) {
     return false;
 }
 
-std::unique_ptr<Mesh> XMLLoader::loadFromZip(const std::string& filename, Progress_abstract* progress) {
-    if (progress) {
-        progress->setMessage("Opening archive...");
-        progress->setProgress(0.1f);
+namespace {
+
+bool isXMLEntryName(const std::string& name) {
+    size_t dotPos = name.find_last_of('.');
+    if (dotPos != std::string::npos) {
+        std::string ext = name.substr(dotPos);
+        return (ext == ".xml" || ext == ".XML");
     }
-    
+    return false;
+}
+
+struct archive* openArchive(const std::string& filename) {
     struct archive* a = archive_read_new();
     archive_read_support_filter_all(a);
     archive_read_support_format_all(a);
@@ -224,77 +430,215 @@ std::unique_ptr<Mesh> XMLLoader::loadFromZip(const std::string& filename, Progre
         archive_read_free(a);
         return nullptr;
     }
+    return a;
+}
+
+// Advance to the next .xml entry, skipping everything else
+bool nextXMLEntry(struct archive* a, struct archive_entry*& entry) {
+    while (archive_read_next_header(a, &entry) == ARCHIVE_OK) {
+        if (isXMLEntryName(archive_entry_pathname(entry))) {
+            return true;
+        }
+        archive_read_data_skip(a);
+    }
+    return false;
+}
+
+// Only the first XML file is used; mention any others like the original loader did
+void warnAboutExtraXMLEntries(struct archive* a) {
+    struct archive_entry* entry;
+    archive_read_data_skip(a);
+    while (nextXMLEntry(a, entry)) {
+        std::cerr << "Warning: Multiple XML files found in zip. Using first one." << std::endl;
+        archive_read_data_skip(a);
+    }
+}
+
+// Decompressed bytes per queue slot, and slots in flight between the reader
+// thread and the parser; together they bound the inflated data held in memory
+constexpr size_t kZipChunkBytes = size_t(1) << 20;
+constexpr size_t kZipQueueDepth = 4;
+
+// Inflate the current entry on a reader thread and parse it on this thread as
+// blocks arrive, so decompression overlaps parsing and the entry is never held
+// in memory as a whole. Returns false if the parser rejected the document;
+// archive errors are reported through `readError`.
+bool streamArchiveEntry(struct archive* a, struct archive_entry* entry, XMLGeometry& geometry,
+                        Progress_abstract* progress, std::string& readError) {
+    BoundedQueue<std::vector<char>> filled(kZipQueueDepth);
+    BoundedQueue<std::vector<char>> recycled(kZipQueueDepth + 2);
+    
+    std::thread reader([&]() {
+        std::vector<char> chunk;
+        chunk.reserve(kZipChunkBytes);
+        bool stopped = false;
+        while (!stopped) {
+            const void* block = nullptr;
+            size_t size = 0;
+            la_int64_t offset = 0;
+            int r = archive_read_data_block(a, &block, &size, &offset);
+            if (r == ARCHIVE_EOF) {
+                break;
+            }
+            if (r != ARCHIVE_OK && r != ARCHIVE_WARN) {
+                readError = archive_error_string(a) ? archive_error_string(a) : "unknown error";
+                break;
+            }
+            
+            // Repack libarchive's blocks (whose buffer is reused on the next call) into full chunks
+            const char* bytes = static_cast<const char*>(block);
+            while (size > 0 && !stopped) {
+                const size_t count = std::min(size, kZipChunkBytes - chunk.size());
+                chunk.insert(chunk.end(), bytes, bytes + count);
+                bytes += count;
+                size -= count;
+                if (chunk.size() == kZipChunkBytes) {
+                    // push() fails once the parser has given up on the document
+                    stopped = !filled.push(std::move(chunk));
+                    if (!recycled.tryPop(chunk)) {
+                        chunk = std::vector<char>();
+                        chunk.reserve(kZipChunkBytes);
+                    }
+                    chunk.clear();
+                }
+            }
+        }
+        if (!stopped && !chunk.empty()) {
+            filled.push(std::move(chunk));
+        }
+        filled.close();
+    });
+    
+    const la_int64_t entrySize = archive_entry_size_is_set(entry) ? archive_entry_size(entry) : 0;
+    XMLStreamParser parser(geometry);
+    std::vector<char> chunk;
+    size_t bytesParsed = 0;
+    bool parsed = true;
+    while (filled.pop(chunk)) {
+        if (isCancelled(progress) || !parser.feed(chunk.data(), chunk.size())) {
+            parsed = false;
+            filled.close(); // stops the reader
+            break;
+        }
+        bytesParsed += chunk.size();
+        reportParseProgress(progress, bytesParsed, static_cast<size_t>(entrySize), 0.3f);
+        recycled.push(std::move(chunk));
+    }
+    reader.join();
+    
+    if (!readError.empty() || isCancelled(progress)) {
+        return false;
+    }
+    if (!parser.finish()) {
+        std::cerr << "Streaming XML parse failed (" << parser.error() << "), retrying with DOM parser" << std::endl;
+        return false;
+    }
+    return parsed;
+}
+
+} // namespace
+
+std::unique_ptr<Mesh> XMLLoader::loadFromZip(const std::string& filename, Progress_abstract* progress) {
+    if (progress) {
+        progress->setMessage("Opening archive...");
+        progress->setProgress(0.1f);
+    }
+    
+    struct archive* a = openArchive(filename);
+    if (!a) {
+        return nullptr;
+    }
     
     if (progress) {
         progress->setMessage("Reading archive contents...");
         progress->setProgress(0.2f);
     }
     
-    std::unique_ptr<Mesh> mesh = nullptr;
     struct archive_entry* entry;
-    bool foundXML = false;
+    if (!nextXMLEntry(a, entry)) {
+        archive_read_free(a);
+        std::cerr << "No XML file found in zip archive" << std::endl;
+        return nullptr;
+    }
     
-    // Iterate through entries in the archive
-    while (archive_read_next_header(a, &entry) == ARCHIVE_OK) {
-        const char* entryName = archive_entry_pathname(entry);
-        std::string name(entryName);
-        
-        // Check if this is an XML file
-        size_t dotPos = name.find_last_of('.');
-        if (dotPos != std::string::npos) {
-            std::string ext = name.substr(dotPos);
-            if (ext == ".xml" || ext == ".XML") {
-                if (foundXML) {
-                    std::cerr << "Warning: Multiple XML files found in zip. Using first one." << std::endl;
-                    archive_read_data_skip(a);
-                    continue;
-                }
-                
-                foundXML = true;
-                
-                // Read the entire file content
-                size_t size = archive_entry_size(entry);
-                std::vector<char> buffer(size + 1);
-                
-                la_ssize_t bytes_read = archive_read_data(a, buffer.data(), size);
-                if (bytes_read < 0) {
-                    std::cerr << "Error reading from archive: " << archive_error_string(a) << std::endl;
-                    archive_read_free(a);
-                    return nullptr;
-                }
-                
-                buffer[bytes_read] = '\0';
-                
-                if (progress) {
-                    progress->setMessage("Parsing XML from archive...");
-                    progress->setProgress(0.3f);
-                }
-                
-                // Parse the XML from the buffer
-                pugi::xml_document doc;
-                pugi::xml_parse_result result = doc.load_buffer(buffer.data(), bytes_read);
-                
-                if (!result) {
-                    std::cerr << "Failed to parse XML from zip: " << result.description() << std::endl;
-                    archive_read_free(a);
-                    return nullptr;
-                }
-                
-                mesh = loadFromXMLString(doc, progress);
-                continue;
-            }
+    if (progress) {
+        progress->setMessage("Parsing XML from archive...");
+        progress->setProgress(0.3f);
+    }
+    
+    XMLGeometry geometry;
+    std::string readError;
+    if (!streamArchiveEntry(a, entry, geometry, progress, readError)) {
+        archive_read_free(a);
+        if (isCancelled(progress)) {
+            return nullptr;
         }
-        
-        // Skip non-XML files
-        archive_read_data_skip(a);
+        if (!readError.empty()) {
+            std::cerr << "Error reading from archive: " << readError << std::endl;
+            return nullptr;
+        }
+        // Part of the entry has been consumed; reopen the archive for the DOM parser
+        return loadFromZipInMemory(filename, progress);
     }
     
+    warnAboutExtraXMLEntries(a);
     archive_read_free(a);
     
-    if (!foundXML) {
+    return buildMesh(geometry, progress);
+}
+
+std::unique_ptr<Mesh> XMLLoader::loadFromZipInMemory(const std::string& filename, Progress_abstract* progress) {
+    struct archive* a = openArchive(filename);
+    if (!a) {
+        return nullptr;
+    }
+    
+    struct archive_entry* entry;
+    if (!nextXMLEntry(a, entry)) {
+        archive_read_free(a);
         std::cerr << "No XML file found in zip archive" << std::endl;
         return nullptr;
     }
     
-    return mesh;
+    // Read the entire file content (the entry size may be unknown for streamed archives)
+    std::vector<char> buffer;
+    if (archive_entry_size_is_set(entry) && archive_entry_size(entry) > 0) {
+        buffer.reserve(static_cast<size_t>(archive_entry_size(entry)));
+    }
+    for (;;) {
+        if (isCancelled(progress)) {
+            archive_read_free(a);
+            return nullptr;
+        }
+        const void* block = nullptr;
+        size_t size = 0;
+        la_int64_t offset = 0;
+        int r = archive_read_data_block(a, &block, &size, &offset);
+        if (r == ARCHIVE_EOF) {
+            break;
+        }
+        if (r != ARCHIVE_OK && r != ARCHIVE_WARN) {
+            std::cerr << "Error reading from archive: " << archive_error_string(a) << std::endl;
+            archive_read_free(a);
+            return nullptr;
+        }
+        buffer.insert(buffer.end(), static_cast<const char*>(block), static_cast<const char*>(block) + size);
+    }
+    archive_read_free(a);
+    
+    if (progress) {
+        progress->setMessage("Parsing XML from archive...");
+        progress->setProgress(0.3f);
+    }
+    
+    // Parse the XML from the buffer
+    pugi::xml_document doc;
+    pugi::xml_parse_result result = doc.load_buffer(buffer.data(), buffer.size());
+    
+    if (!result) {
+        std::cerr << "Failed to parse XML from zip: " << result.description() << std::endl;
+        return nullptr;
+    }
+    
+    return loadFromXMLString(doc, progress);
 }
@@ -11,6 +11,7 @@ class Progress_abstract;
 namespace pugi {
     class xml_document;
 }
+struct XMLGeometry;
 
 class XMLLoader {
 public:
@@ -23,5 +24,12 @@ private:
     static bool isXMLGeometry(const std::string& filename);
     static bool isZipFile(const std::string& filename);
     static std::unique_ptr<Mesh> loadFromZip(const std::string& filename, Progress_abstract* progress);
+    // Inflate the whole XML entry and parse it with pugixml (fallback for loadFromZip)
+    static std::unique_ptr<Mesh> loadFromZipInMemory(const std::string& filename, Progress_abstract* progress);
     static std::unique_ptr<Mesh> loadFromXMLString(const pugi::xml_document& doc, Progress_abstract* progress);
+    // Streaming parse of a file or buffer; false means the caller should retry with the DOM parser
+    static bool streamXMLFile(const std::string& filename, XMLGeometry& geometry, Progress_abstract* progress);
+    static bool streamXMLBuffer(const char* data, size_t size, XMLGeometry& geometry, Progress_abstract* progress);
+    // Resolve vertex IDs, compute facet normals and build the mesh
+    static std::unique_ptr<Mesh> buildMesh(const XMLGeometry& geometry, Progress_abstract* progress);
 };
@@ -0,0 +1,505 @@
+#include "XMLStreamParser.h"
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline bool nameEquals(const char* name, size_t length, const char* expected) {
+    return std::strlen(expected) == length && std::memcmp(name, expected, length) == 0;
+}
+
+// First occurrence of `sequence` in [p, end), or nullptr
+const char* findSequence(const char* p, const char* end, const char* sequence) {
+    const size_t length = std::strlen(sequence);
+    while (end - p >= static_cast<ptrdiff_t>(length)) {
+        const char* candidate = static_cast<const char*>(std::memchr(p, sequence[0], end - p - length + 1));
+        if (!candidate) {
+            return nullptr;
+        }
+        if (std::memcmp(candidate, sequence, length) == 0) {
+            return candidate;
+        }
+        p = candidate + 1;
+    }
+    return nullptr;
+}
+
+// Closing '>' of a start tag, skipping any '>' inside quoted attribute values
+const char* findTagEnd(const char* p, const char* end) {
+    char quote = 0;
+    for (; p < end; ++p) {
+        const char c = *p;
+        if (quote) {
+            if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '>') {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+// Closing '>' of a <!DOCTYPE ...> declaration, which may hold an internal subset in [...]
+const char* findDoctypeEnd(const char* p, const char* end) {
+    char quote = 0;
+    int depth = 0;
+    for (; p < end; ++p) {
+        const char c = *p;
+        if (quote) {
+            if (c == quote) quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '[') {
+            ++depth;
+        } else if (c == ']') {
+            --depth;
+        } else if (c == '>' && depth <= 0) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+// Attribute values are converted like pugixml's as_int()/as_float(), so both
+// parsers produce identical meshes: leading whitespace and an explicit sign are
+// accepted, trailing garbage is ignored and unparsable values read as 0
+int parseInt(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) ++p;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+    int base = 10;
+    if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        base = 16;
+        p += 2;
+    }
+    unsigned long long magnitude = 0;
+    auto result = std::from_chars(p, end, magnitude, base);
+    if (result.ec == std::errc::result_out_of_range) {
+        return negative ? INT_MIN : INT_MAX;
+    }
+    if (result.ec != std::errc()) {
+        return 0;
+    }
+    if (negative) {
+        return magnitude >= static_cast<unsigned long long>(INT_MAX) + 1 ? INT_MIN : -static_cast<int>(magnitude);
+    }
+    return magnitude > static_cast<unsigned long long>(INT_MAX) ? INT_MAX : static_cast<int>(magnitude);
+}
+
+float parseFloat(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) ++p;
+    if (p < end && *p == '+') {
+        ++p; // strtod accepts an explicit '+', from_chars does not
+    }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    // Parse as double and round once, exactly like static_cast<float>(strtod())
+    double value = 0.0;
+    auto result = std::from_chars(p, end, value);
+    if (result.ec == std::errc::result_out_of_range) {
+        return static_cast<float>(std::strtod(std::string(p, end).c_str(), nullptr));
+    }
+    return result.ec == std::errc() ? static_cast<float>(value) : 0.0f;
+#else
+    // Standard library without floating-point from_chars: strtod on a bounded copy
+    char buffer[64];
+    const size_t length = std::min(static_cast<size_t>(end - p), sizeof(buffer) - 1);
+    std::memcpy(buffer, p, length);
+    buffer[length] = '\0';
+    return static_cast<float>(std::strtod(buffer, nullptr));
+#endif
+}
+
+// Walks the name="value" pairs of a start tag
+class AttributeReader {
+public:
+    AttributeReader(const char* p, const char* end) : m_p(p), m_end(end) {}
+
+    // Returns false at the end of the list, or on a syntax error (see failed())
+    bool next(const char*& name, size_t& nameLength, const char*& value, size_t& valueLength) {
+        while (m_p < m_end && isSpace(*m_p)) ++m_p;
+        if (m_p == m_end) {
+            return false;
+        }
+        name = m_p;
+        while (m_p < m_end && *m_p != '=' && !isSpace(*m_p)) ++m_p;
+        nameLength = static_cast<size_t>(m_p - name);
+        while (m_p < m_end && isSpace(*m_p)) ++m_p;
+        if (nameLength == 0 || m_p == m_end || *m_p != '=') {
+            m_failed = true;
+            return false;
+        }
+        ++m_p;
+        while (m_p < m_end && isSpace(*m_p)) ++m_p;
+        if (m_p == m_end || (*m_p != '"' && *m_p != '\'')) {
+            m_failed = true;
+            return false;
+        }
+        const char quote = *m_p++;
+        value = m_p;
+        const char* close = static_cast<const char*>(std::memchr(m_p, quote, m_end - m_p));
+        if (!close) {
+            m_failed = true;
+            return false;
+        }
+        valueLength = static_cast<size_t>(close - value);
+        m_p = close + 1;
+        return true;
+    }
+
+    bool failed() const { return m_failed; }
+
+private:
+    const char* m_p;
+    const char* m_end;
+    bool m_failed = false;
+};
+
+} // namespace
+
+bool XMLStreamParser::feed(const char* data, size_t size) {
+    if (m_failed) {
+        return false;
+    }
+
+    // Finish the token left over from the previous piece. Bytes are appended in
+    // growing steps so a long comment or CDATA section is not rescanned quadratically,
+    // and parsing switches back to the caller's buffer as soon as the token is complete.
+    while (!m_pending.empty()) {
+        if (size == 0) {
+            return true;
+        }
+        const size_t carried = m_pending.size();
+        const size_t take = std::min(size, std::max<size_t>(carried, 4096));
+        m_pending.append(data, take);
+        const size_t used = parse(m_pending.data(), m_pending.size());
+        if (m_failed) {
+            return false;
+        }
+        if (used >= carried) {
+            data += used - carried;
+            size -= used - carried;
+            m_pending.clear();
+        } else {
+            m_pending.erase(0, used);
+            data += take;
+            size -= take;
+        }
+    }
+
+    const size_t used = parse(data, size);
+    if (m_failed) {
+        return false;
+    }
+    m_pending.assign(data + used, size - used);
+    return true;
+}
+
+bool XMLStreamParser::finish() {
+    if (m_failed) {
+        return false;
+    }
+    if (!m_pending.empty()) {
+        fail("unexpected end of document", m_consumed);
+        return false;
+    }
+    if (!m_open.empty()) {
+        fail("element <" + m_names.substr(m_open.back().nameOffset) + "> is not closed", m_consumed);
+        return false;
+    }
+    if (!m_seenElement) {
+        fail("no document element found", m_consumed);
+        return false;
+    }
+    return true;
+}
+
+void XMLStreamParser::fail(const std::string& message, size_t offset) {
+    m_failed = true;
+    m_error = message + " at offset " + std::to_string(offset);
+}
+
+size_t XMLStreamParser::parse(const char* data, size_t size) {
+    const char* const end = data + size;
+    const char* p = data;
+
+    if (m_consumed == 0) {
+        // Encoding check on the first bytes of the document
+        if (size < 4) {
+            return 0;
+        }
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        if (bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF) {
+            p += 3; // UTF-8 byte order mark
+        } else if (bytes[0] == 0 || bytes[1] == 0 ||
+                   (bytes[0] == 0xFE && bytes[1] == 0xFF) || (bytes[0] == 0xFF && bytes[1] == 0xFE)) {
+            fail("unsupported encoding (only UTF-8 is streamed)", 0);
+            return 0;
+        }
+    }
+
+    auto offsetOf = [&](const char* at) { return m_consumed + static_cast<size_t>(at - data); };
+
+    while (p < end) {
+        if (*p != '<') {
+            // Character data is never needed for geometry
+            const char* open = static_cast<const char*>(std::memchr(p, '<', end - p));
+            if (!open) {
+                p = end;
+                break;
+            }
+            p = open;
+        }
+        if (end - p < 2) {
+            break;
+        }
+
+        const char kind = p[1];
+        if (kind == '/') {
+            // End tag
+            const char* close = static_cast<const char*>(std::memchr(p + 2, '>', end - p - 2));
+            if (!close) {
+                break;
+            }
+            const char* nameEnd = close;
+            while (nameEnd > p + 2 && isSpace(nameEnd[-1])) --nameEnd;
+            if (!endElement(p + 2, static_cast<size_t>(nameEnd - (p + 2)))) {
+                fail(m_error, offsetOf(p));
+                return static_cast<size_t>(p - data);
+            }
+            p = close + 1;
+        } else if (kind == '?') {
+            // Processing instruction or XML declaration
+            const char* close = findSequence(p + 2, end, "?>");
+            if (!close) {
+                break;
+            }
+            p = close + 2;
+        } else if (kind == '!') {
+            if (end - p < 4) {
+                break;
+            }
+            const char* close = nullptr;
+            if (p[2] == '-' && p[3] == '-') {
+                close = findSequence(p + 4, end, "-->");
+                if (!close) {
+                    break;
+                }
+                p = close + 3;
+            } else if (p[2] == '[' || p[2] == 'D') {
+                if (end - p < 9) {
+                    break;
+                }
+                if (std::memcmp(p, "<![CDATA[", 9) == 0) {
+                    close = findSequence(p + 9, end, "]]>");
+                    if (!close) {
+                        break;
+                    }
+                    p = close + 3;
+                } else if (std::memcmp(p, "<!DOCTYPE", 9) == 0) {
+                    close = findDoctypeEnd(p + 9, end);
+                    if (!close) {
+                        break;
+                    }
+                    p = close + 1;
+                } else {
+                    fail("unrecognized markup", offsetOf(p));
+                    return static_cast<size_t>(p - data);
+                }
+            } else {
+                fail("unrecognized markup", offsetOf(p));
+                return static_cast<size_t>(p - data);
+            }
+        } else {
+            // Start tag or empty-element tag
+            const char* close = findTagEnd(p + 1, end);
+            if (!close) {
+                break;
+            }
+            const char* name = p + 1;
+            const char* nameEnd = name;
+            while (nameEnd < close && !isSpace(*nameEnd) && *nameEnd != '/') ++nameEnd;
+            const size_t nameLength = static_cast<size_t>(nameEnd - name);
+            const bool selfClosing = close[-1] == '/' && close - 1 >= nameEnd;
+            if (nameLength == 0) {
+                fail("invalid start tag", offsetOf(p));
+                return static_cast<size_t>(p - data);
+            }
+            if (!startElement(name, nameLength, nameEnd, selfClosing ? close - 1 : close) ||
+                (selfClosing && !endElement(name, nameLength))) {
+                fail(m_error, offsetOf(p));
+                return static_cast<size_t>(p - data);
+            }
+            p = close + 1;
+        }
+    }
+
+    m_consumed += static_cast<size_t>(p - data);
+    return static_cast<size_t>(p - data);
+}
+
+XMLStreamParser::Section XMLStreamParser::childSection(const char* name, size_t nameLength) {
+    // Mirrors doc.child("SimulationEnvironment").child("Geometry").child(...):
+    // only the first matching element of each section is used
+    if (m_open.empty()) {
+        if (!m_seenRoot && nameEquals(name, nameLength, "SimulationEnvironment")) {
+            m_seenRoot = true;
+            return Section::Root;
+        }
+        return Section::Skip;
+    }
+
+    switch (m_open.back().section) {
+        case Section::Root:
+            if (!m_seenGeometry && nameEquals(name, nameLength, "Geometry")) {
+                m_seenGeometry = true;
+                m_geometry.hasGeometry = true;
+                return Section::Geometry;
+            }
+            break;
+        case Section::Geometry:
+            if (!m_seenVertices && nameEquals(name, nameLength, "Vertices")) {
+                m_seenVertices = true;
+                m_geometry.hasVertices = true;
+                return Section::Vertices;
+            }
+            if (!m_seenFacets && nameEquals(name, nameLength, "Facets")) {
+                m_seenFacets = true;
+                m_geometry.hasFacets = true;
+                return Section::Facets;
+            }
+            break;
+        case Section::Vertices:
+            if (nameEquals(name, nameLength, "Vertex")) {
+                return Section::Vertex;
+            }
+            break;
+        case Section::Facets:
+            if (nameEquals(name, nameLength, "Facet")) {
+                m_facetHasIndices = false;
+                return Section::Facet;
+            }
+            break;
+        case Section::Facet:
+            if (!m_facetHasIndices && nameEquals(name, nameLength, "Indices")) {
+                m_facetHasIndices = true;
+                return Section::Indices;
+            }
+            break;
+        case Section::Indices:
+            if (nameEquals(name, nameLength, "Indice")) {
+                return Section::Indice;
+            }
+            break;
+        default:
+            break;
+    }
+    return Section::Skip;
+}
+
+bool XMLStreamParser::startElement(const char* name, size_t nameLength,
+                                   const char* attributes, const char* attributesEnd) {
+    m_seenElement = true;
+    const Section section = childSection(name, nameLength);
+
+    if (section == Section::Vertices || section == Section::Facets ||
+        section == Section::Vertex || section == Section::Indice) {
+        // Only these elements carry attributes the geometry needs
+        AttributeReader reader(attributes, attributesEnd);
+        const char* attrName;
+        const char* value;
+        size_t attrLength, valueLength;
+        bool seen[4] = {false, false, false, false};
+        int id = 0;
+        float xyz[3] = {0.0f, 0.0f, 0.0f};
+        int nb = 0;
+        int vertexId = 0;
+        while (reader.next(attrName, attrLength, value, valueLength)) {
+            const char* valueEnd = value + valueLength;
+            // The first attribute of a given name wins, like xml_node::attribute()
+            if (section == Section::Vertex) {
+                if (attrLength == 1 && attrName[0] >= 'x' && attrName[0] <= 'z') {
+                    const int axis = attrName[0] - 'x';
+                    if (!seen[axis]) {
+                        seen[axis] = true;
+                        xyz[axis] = parseFloat(value, valueEnd);
+                    }
+                } else if (!seen[3] && nameEquals(attrName, attrLength, "id")) {
+                    seen[3] = true;
+                    id = parseInt(value, valueEnd);
+                }
+            } else if (section == Section::Indice) {
+                if (!seen[0] && nameEquals(attrName, attrLength, "vertex")) {
+                    seen[0] = true;
+                    vertexId = parseInt(value, valueEnd);
+                }
+            } else if (!seen[0] && nameEquals(attrName, attrLength, "nb")) {
+                seen[0] = true;
+                nb = parseInt(value, valueEnd);
+            }
+        }
+        if (reader.failed()) {
+            m_error = "malformed attribute in <" + std::string(name, nameLength) + ">";
+            return false;
+        }
+
+        switch (section) {
+            case Section::Vertices:
+                m_geometry.declaredVertices = nb;
+                if (nb > 0) {
+                    m_geometry.vertexIds.reserve(static_cast<size_t>(nb));
+                    m_geometry.positions.reserve(static_cast<size_t>(nb));
+                }
+                break;
+            case Section::Facets:
+                m_geometry.declaredFacets = nb;
+                if (nb > 0) {
+                    m_geometry.facetOffsets.reserve(static_cast<size_t>(nb) + 1);
+                    m_geometry.facetVertexIds.reserve(static_cast<size_t>(nb) * 3);
+                }
+                break;
+            case Section::Vertex:
+                m_geometry.vertexIds.push_back(id);
+                m_geometry.positions.emplace_back(xyz[0], xyz[1], xyz[2]);
+                break;
+            case Section::Indice:
+                m_geometry.facetVertexIds.push_back(vertexId);
+                break;
+            default:
+                break;
+        }
+    }
+
+    m_open.push_back({m_names.size(), section});
+    m_names.append(name, nameLength);
+    return true;
+}
+
+bool XMLStreamParser::endElement(const char* name, size_t nameLength) {
+    if (m_open.empty()) {
+        m_error = "unexpected end tag </" + std::string(name, nameLength) + ">";
+        return false;
+    }
+    const OpenElement element = m_open.back();
+    if (m_names.compare(element.nameOffset, std::string::npos, name, nameLength) != 0) {
+        m_error = "end tag </" + std::string(name, nameLength) + "> does not match <" +
+                  m_names.substr(element.nameOffset) + ">";
+        return false;
+    }
+    if (element.section == Section::Indices) {
+        m_geometry.facetOffsets.push_back(static_cast<unsigned int>(m_geometry.facetVertexIds.size()));
+    }
+    m_open.pop_back();
+    m_names.resize(element.nameOffset);
+    return true;
+}
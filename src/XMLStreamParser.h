@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Raw geometry section of a MolFlow XML file as it appears in the document:
+// vertices with their file IDs and, for every facet that has an <Indices>
+// list, the vertex IDs it references (flat array + offsets, like FacetList)
+struct XMLGeometry {
+    std::vector<int> vertexIds;
+    std::vector<glm::vec3> positions;
+    std::vector<int> facetVertexIds;
+    std::vector<unsigned int> facetOffsets{0};
+    int declaredVertices = 0; // "nb" attributes, used for reserving and progress
+    int declaredFacets = 0;
+    bool hasGeometry = false;
+    bool hasVertices = false;
+    bool hasFacets = false;
+
+    size_t facetCount() const { return facetOffsets.size() - 1; }
+};
+
+// Incremental (push) parser for the geometry section of a MolFlow XML document.
+// The document can be fed in pieces of any size; vertices and facet index lists
+// are appended to the XMLGeometry as soon as their elements have been read.
+// Everything outside SimulationEnvironment/Geometry/{Vertices,Facets}
+// (simulation settings, textures, results) is only checked for well-formedness
+// and never stored.
+// Only UTF-8 (or ASCII-compatible) input is supported; anything else is reported
+// as an error so the caller can fall back to a DOM parser.
+class XMLStreamParser {
+public:
+    explicit XMLStreamParser(XMLGeometry& geometry) : m_geometry(geometry) {}
+
+    // Parse the next piece of the document. Returns false once the input is malformed.
+    bool feed(const char* data, size_t size);
+    // Signal the end of the document. Returns false if it is malformed or incomplete.
+    bool finish();
+
+    bool failed() const { return m_failed; }
+    const std::string& error() const { return m_error; }
+
+private:
+    enum class Section : unsigned char { Skip, Root, Geometry, Vertices, Vertex, Facets, Facet, Indices, Indice };
+    struct OpenElement {
+        size_t nameOffset; // start of the element name in m_names
+        Section section;
+    };
+
+    // Parse as many complete tokens as possible; returns the number of bytes consumed
+    size_t parse(const char* data, size_t size);
+    bool startElement(const char* name, size_t nameLength, const char* attributes, const char* attributesEnd);
+    bool endElement(const char* name, size_t nameLength);
+    Section childSection(const char* name, size_t nameLength);
+    void fail(const std::string& message, size_t offset);
+
+    XMLGeometry& m_geometry;
+    std::string m_pending;  // unfinished token carried over to the next feed()
+    size_t m_consumed = 0;  // bytes of the document fully parsed so far
+    std::string m_names;    // names of the open elements, concatenated
+    std::vector<OpenElement> m_open;
+    bool m_seenElement = false;
+    bool m_seenRoot = false;
+    bool m_seenGeometry = false;
+    bool m_seenVertices = false;
+    bool m_seenFacets = false;
+    bool m_facetHasIndices = false;
+    bool m_failed = false;
+    std::string m_error;
+};
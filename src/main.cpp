@@ -11,10 +11,16 @@
 #include <vector>
 #include <cmath>
 #include <filesystem>
-#include "STLLoader.h"
-#include "XMLLoader.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include "AsyncMeshLoader.h"
+#include "MeshWelder.h"
+#include "OffscreenContext.h"
 #include "Renderer.h"
-#include "progress/ConsoleProgress.h"
+#include "ScreenProjector.h"
+#include "ThumbnailRenderer.h"
 
 const int WINDOW_WIDTH = 1024;
 const int WINDOW_HEIGHT = 768;
@@ -35,17 +41,45 @@ public:
 #else
                     , m_useOpenMP(false)
 #endif
-                    , m_cacheValid(false)
+                    , m_pickingBackend(PickingBackend::RayCast)
+                    , m_gpuPickStart(0)
+                    , m_gpuPickCursor(0.0f)
+                    , m_gpuPickMvp(1.0f)
+                    , m_gpuPickViewport(1.0f)
+                    , m_gpuPickReleased(false)
                     , m_isZKeyPressed(false)
                     , m_isDKeyPressed(false)
                     , m_isLKeyPressed(false)
                     , m_isLeftDragging(false)
-                    , m_drawFacetNormals(false) {}
+                    , m_drawFacetNormals(false)
+                    , m_weldEpsilon(-1.0f)
+                    , m_featureAngle(EdgeExtractor::kDefaultFeatureAngle)
+                    , m_useMeshCache(true)
+                    , m_continuousRendering(false)
+                    , m_needsRedraw(true) {}
     
     ~Application() {
         cleanup();
     }
     
+    // Weld coincident vertices of every loaded mesh (epsilon < 0 disables welding)
+    void setWeldEpsilon(float epsilon) { m_weldEpsilon = epsilon; }
+    
+    // Dihedral angle (degrees) above which a shared edge counts as a feature edge
+    void setFeatureAngle(float degrees) { m_featureAngle = degrees; }
+    
+    // Read and write the on-disk mesh cache (see MeshCache)
+    void setMeshCacheEnabled(bool enabled) { m_useMeshCache = enabled; }
+    
+    // GL debug context and Renderer debug validation (see Renderer::setDebugValidation)
+    void setGLDebug(bool enabled) { m_glDebug = enabled; }
+    
+    // GPU buffer format of every loaded mesh (see MeshRenderOptions)
+    void setRenderOptions(const MeshRenderOptions& options) { m_renderOptions = options; }
+    
+    // Redraw every frame (for benchmarking) instead of only when the view changed
+    void setContinuousRendering(bool enabled) { m_continuousRendering = enabled; }
+    
     bool initialize(const std::string& stlFile) {
         // On macOS, ensure this is a foreground app (not background-only)
         SDL_SetHint(SDL_HINT_MAC_BACKGROUND_APP, "0");
@@ -64,6 +98,10 @@ public:
     // Request MSAA 4x for antialiased wireframe edges
     SDL_GL_SetAttribute(SDL_GL_MULTISAMPLEBUFFERS, 1);
     SDL_GL_SetAttribute(SDL_GL_MULTISAMPLESAMPLES, 4);
+        // A debug context makes drivers report errors and misuse through KHR_debug
+        if (m_glDebug) {
+            SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+        }
         
         // Create window
         m_window = SDL_CreateWindow(
@@ -151,6 +189,7 @@ public:
             std::cerr << "Failed to initialize renderer" << std::endl;
             return false;
         }
+        m_renderer.setDebugValidation(m_glDebug);
         
         // If no file path was provided, open file dialog AFTER window is active
         if (!stlFile.empty()) {
@@ -162,16 +201,27 @@ public:
         return true;
     }
     
-    void run() {
+    // Returns the process exit code
+    int run() {
         m_running = true;
         m_lastFpsTime = SDL_GetTicksNS();
         m_frameCount = 0;
         
         while (m_running) {
+            waitForEvents();
             handleEvents();
-            render();
-            updateFPS();
+            pollGpuPick();
+            pollLoader();
+            if (m_renderer.pollLevelsOfDetail()) {
+                m_needsRedraw = true;
+            }
+            if (m_continuousRendering || m_needsRedraw) {
+                m_needsRedraw = false;
+                render();
+                updateFPS();
+            }
         }
+        return m_exitCode;
     }
     
 private:
@@ -246,8 +296,15 @@ private:
             #version 330 core
             layout (location = 0) in vec3 aPos;
             layout (location = 1) in vec3 aColor;
-            uniform mat4 projection;
-            uniform mat4 view;
+            // Camera shared with the mesh shaders (see shaders/vertex.glsl)
+            layout(std140) uniform FrameUniforms {
+                mat4 projection;
+                mat4 view;
+                mat4 model;
+                mat4 modelView;
+                mat3 normalMatrix;
+                vec3 lightDirectionVS;
+            };
             out vec3 Color;
             void main(){
                 Color = aColor;
@@ -274,6 +331,7 @@ private:
         glLinkProgram(m_axesProgram);
         glDeleteShader(vs);
         glDeleteShader(fs);
+        Renderer::bindFrameUniforms(m_axesProgram);
 
         glGenVertexArrays(1, &m_axesVAO);
         glGenBuffers(1, &m_axesVBO);
@@ -315,28 +373,50 @@ private:
         if (elapsed >= 1000000000ULL) {
             m_fps = m_frameCount * 1000000000.0f / elapsed;
             
-            // Update window title with FPS
-            // Calculate triangle count from facets (each facet is triangulated as (n-2) triangles)
-            size_t triCount = 0;
-            if (m_renderer.getMesh()) {
-                for (const auto& facet : m_renderer.getMesh()->facets) {
-                    if (facet.indices.size() >= 3) {
-                        triCount += facet.indices.size() - 2;
-                    }
+            // Update window title with FPS (the loader owns the title while loading)
+            const Mesh* mesh = m_renderer.getMesh();
+            if (!m_loader.isLoading() && mesh) {
+                std::string title = "STL Viewer - FPS: " + std::to_string(static_cast<int>(m_fps)) +
+                    " | Facets: " + std::to_string(mesh->facets.size()) +
+                    " | Tris: " + std::to_string(m_renderer.getVisibleTriangleCount()) +
+                    "/" + std::to_string(mesh->triangleFacets.size()) +
+                    " in " + std::to_string(m_renderer.getSolidDrawCount()) + " draws";
+                if (m_renderer.getLevelOfDetail() > 0) {
+                    title += " (LOD " + std::to_string(m_renderer.getLevelOfDetail()) + ")";
                 }
+                SDL_SetWindowTitle(m_window, title.c_str());
             }
-            std::string title = "STL Viewer - FPS: " + std::to_string(static_cast<int>(m_fps)) +
-                " | Facets: " + std::to_string(m_renderer.getMesh()->facets.size()) +
-                " | Tris: " + std::to_string(triCount);
-            SDL_SetWindowTitle(m_window, title.c_str());
             
             m_frameCount = 0;
             m_lastFpsTime = currentTime;
         }
     }
+    // Sleep until there is something to do: an event, or a background job to
+    // poll. Returns at once in continuous mode or when a redraw is pending.
+    void waitForEvents() {
+        if (m_continuousRendering || m_needsRedraw) {
+            return;
+        }
+        // A GPU pick, loader progress and finished levels of detail arrive
+        // without an event. A pick result is checked about once a frame, the
+        // slower background jobs less often; nothing pending sleeps until input
+        int timeoutMs = -1;
+        if (m_renderer.isPickPending()) {
+            timeoutMs = 16;
+        } else if (m_loader.isLoading() || m_renderer.isBuildingLevelsOfDetail()) {
+            timeoutMs = 50;
+        }
+        SDL_WaitEventTimeout(nullptr, timeoutMs);
+    }
+    
     void handleEvents() {
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
+            // Everything but plain mouse movement can change the picture (input,
+            // expose, resize, focus); redrawing on all of them keeps this simple
+            if (event.type != SDL_EVENT_MOUSE_MOTION || event.motion.state != 0) {
+                m_needsRedraw = true;
+            }
             switch (event.type) {
                 case SDL_EVENT_QUIT:
                     m_running = false;
@@ -362,7 +442,6 @@ private:
                             m_lightRotationY += dxAngle;
                             m_lightRotationX += dyAngle;
                             m_lightRotationX = glm::clamp(m_lightRotationX, -89.0f, 89.0f);
-                            m_cacheValid = false;
                         } else {
                             // Normal right drag = model rotation
                             float dxAngle = event.motion.xrel * 0.25f;
@@ -370,7 +449,6 @@ private:
                             m_rotationY += dxAngle;
                             m_rotationX += dyAngle;
                             m_rotationX = glm::clamp(m_rotationX, -89.0f, 89.0f);
-                            m_cacheValid = false;
                         }
                     }
                     // Handle middle mouse button panning
@@ -385,7 +463,6 @@ private:
                         // Update pan so the model follows the mouse (drag right -> model right, drag down -> model down)
                         m_pan.x += event.motion.xrel * worldPerPixelX;
                         m_pan.y -= event.motion.yrel * worldPerPixelY;
-                        m_cacheValid = false;
                     }
                     // Handle trackpad alternatives with left mouse button
                     if (event.motion.state & SDL_BUTTON_MASK(SDL_BUTTON_LEFT) && m_isLeftDragging) {
@@ -406,23 +483,21 @@ private:
                             // Update pan so the model follows the mouse
                             m_pan.x += event.motion.xrel * worldPerPixelX;
                             m_pan.y -= event.motion.yrel * worldPerPixelY;
-                            m_cacheValid = false;
                         }
                     }
                     break;
                 case SDL_EVENT_MOUSE_BUTTON_UP:
-                    if (event.button.button == SDL_BUTTON_RIGHT || event.button.button == SDL_BUTTON_MIDDLE) {
+                    // Only rotation invalidates the screen cache; pan and zoom do not
+                    if (event.button.button == SDL_BUTTON_RIGHT && m_pickingBackend == PickingBackend::ScreenCache) {
                         computeScreenCache();
                     }
                     if (event.button.button == SDL_BUTTON_RIGHT && !m_isLKeyPressed) {
+                        // A pending GPU pick still sets its pivot; pollGpuPick() clears it again
+                        m_gpuPickReleased = m_renderer.isPickPending();
                         clearPivot();
                     }
                     if (event.button.button == SDL_BUTTON_LEFT) {
                         m_isLeftDragging = false;
-                        // Recompute screen cache if we were using trackpad controls
-                        if (m_isZKeyPressed || m_isDKeyPressed) {
-                            computeScreenCache();
-                        }
                     }
                     break;
                 case SDL_EVENT_MOUSE_BUTTON_DOWN:
@@ -430,9 +505,6 @@ private:
                         m_isLeftDragging = true;
                     }
                     if (event.button.button == SDL_BUTTON_RIGHT && !m_isLKeyPressed) {
-                        if (!m_cacheValid) {
-                            computeScreenCache();
-                        }
                         pickPivot(event.button.x, event.button.y);
                     }
                     break;
@@ -446,7 +518,6 @@ private:
                     
                 case SDL_EVENT_WINDOW_RESIZED:
                     glViewport(0, 0, event.window.data1, event.window.data2);
-                    m_cacheValid = false;
                     break;
             }
         }
@@ -465,14 +536,12 @@ private:
         m_pan = glm::vec2(0.0f);
         m_pivotActive = false;
         m_showPivotAxes = false;
-        m_cacheValid = false;
     }
 
     void clearPivot() {
         if (!m_renderer.getMesh() || !m_pivotActive) {
             m_pivotActive = false;
             m_showPivotAxes = false;
-            m_cacheValid = false;
             return;
         }
 
@@ -498,7 +567,6 @@ private:
         m_pan.y -= delta.y;
         m_pivotActive = false;
         m_showPivotAxes = false;
-        m_cacheValid = false;
     }
 
     glm::vec2 getNormalizedDeviceCoordinates(float screenX, float screenY) const {
@@ -543,7 +611,6 @@ private:
         m_pan.x += ndcAnchor.x * aspect * zoomChange;
         m_pan.y += ndcAnchor.y * zoomChange;
         m_zoom = newZoom;
-        m_cacheValid = false;
     }
 
     void applyZoomAtScreenPoint(float wheelSteps, float screenX, float screenY) {
@@ -554,6 +621,11 @@ private:
     void handleKeyPress(SDL_Scancode scancode, SDL_Keymod mod) {
         switch (scancode) {
             case SDL_SCANCODE_ESCAPE:
+                if (m_loader.isLoading()) {
+                    std::cout << "ESC pressed - Cancelling load" << std::endl;
+                    m_loader.cancel();
+                    break;
+                }
                 std::cout << "ESC pressed - Quitting" << std::endl;
                 m_running = false;
                 break;
@@ -593,6 +665,12 @@ private:
                 std::cout << "Wireframe: " << (newVal ? "ON" : "OFF") << std::endl;
                 break;
             }
+            case SDL_SCANCODE_F: {
+                bool newVal = !m_renderer.getFeatureEdgesOnly();
+                m_renderer.setFeatureEdgesOnly(newVal);
+                std::cout << "Wireframe edges: " << (newVal ? "feature only" : "all") << std::endl;
+                break;
+            }
             case SDL_SCANCODE_S: {
                 bool newVal = !m_renderer.getDrawSolid();
                 m_renderer.setDrawSolid(newVal);
@@ -612,6 +690,12 @@ private:
                 std::cout << "OpenMP not available in this build" << std::endl;
 #endif
                 break;
+            case SDL_SCANCODE_P:
+                m_pickingBackend = m_pickingBackend == PickingBackend::RayCast ? PickingBackend::ScreenCache
+                                 : m_pickingBackend == PickingBackend::ScreenCache ? PickingBackend::GpuIdBuffer
+                                 : PickingBackend::RayCast;
+                std::cout << "Picking: " << pickingBackendName() << std::endl;
+                break;
             case SDL_SCANCODE_C: {
                 bool enabled = true;
                 // Query current from renderer; we track it via renderer state
@@ -648,30 +732,25 @@ private:
         }
     }
 
-    void render() {
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        
-        // Render background gradient
-        renderBackground();
-        
-        int width, height;
+    // Window size and the camera render() draws with
+    void cameraMatrices(int& width, int& height, glm::mat4& projection, glm::mat4& view, glm::mat4& model) const {
         SDL_GetWindowSize(m_window, &width, &height);
         float aspect = static_cast<float>(width) / static_cast<float>(height);
         
         // Orthogonal projection with large depth range
         float orthoSize = m_zoom;
         float maxExtent = m_renderer.getMesh() ? m_renderer.getMesh()->getMaxExtent() : 100.0f;
-        glm::mat4 projection = glm::ortho(
+        projection = glm::ortho(
             -orthoSize * aspect, orthoSize * aspect,
             -orthoSize, orthoSize,
             -maxExtent * 10.0f, maxExtent * 10.0f  // Much larger near/far planes
         );
         
         // View matrix with panning in XY (ortho)
-        glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(m_pan.x, m_pan.y, 0.0f));
+        view = glm::translate(glm::mat4(1.0f), glm::vec3(m_pan.x, m_pan.y, 0.0f));
         
         // Model matrix (rotation and centering)
-        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::mat4(1.0f);
         if (m_renderer.getMesh()) {
             glm::vec3 center = m_renderer.getMesh()->getCenter();
             if (m_pivotActive) {
@@ -687,17 +766,29 @@ private:
                 model = glm::translate(model, -center);
             }
         }
+    }
+
+    void render() {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        
+        // Render background gradient
+        renderBackground();
+        
+        int width, height;
+        glm::mat4 projection, view, model;
+        cameraMatrices(width, height, projection, view, model);
         
         // Compute light direction from rotation angles
         glm::vec3 lightDirection = glm::vec3(0.0f, -1.0f, 0.0f);
         lightDirection = glm::rotateX(lightDirection, glm::radians(m_lightRotationX));
         lightDirection = glm::rotateY(lightDirection, glm::radians(m_lightRotationY));
         
+        m_renderer.setViewportSize(width, height);
         m_renderer.render(projection, view, model, lightDirection);
 
         // Draw the current rotation center while a right-drag pivot is active.
         if (m_showPivotAxes && m_renderer.getMesh()) {
-            drawPivotAxes(projection, view, model);
+            drawPivotAxes(model);
         }
         
         SDL_GL_SwapWindow(m_window);
@@ -725,6 +816,9 @@ private:
     SDL_Window* m_window;
     SDL_GLContext m_glContext;
     Renderer m_renderer;
+    AsyncMeshLoader m_loader;     // background load; cancelled and joined on destruction
+    std::string m_loadingTitle;   // last window title shown while loading
+    int m_exitCode = 0;
     bool m_running;
     float m_rotationX;
     float m_rotationY;
@@ -756,9 +850,20 @@ private:
 #else
     bool m_useOpenMP;
 #endif
-    // Cached screen-space vertex coordinates and validity flag
-    std::vector<glm::vec2> m_screenCache;
-    bool m_cacheValid;
+    // How a right click finds the rotation pivot
+    enum class PickingBackend {
+        RayCast,     // first triangle under the cursor, via the renderer's BVH
+        ScreenCache, // nearest projected vertex, via m_screenProjector
+        GpuIdBuffer  // triangle under the cursor from an ID buffer, via Renderer::requestPick
+    };
+    PickingBackend m_pickingBackend;
+    Uint64 m_gpuPickStart;     // when the pending GPU pick was requested
+    glm::vec2 m_gpuPickCursor; // and where
+    glm::mat4 m_gpuPickMvp;    // the camera it was requested with, as the view may rotate meanwhile
+    glm::vec2 m_gpuPickViewport;
+    bool m_gpuPickReleased;    // the right button went up before the result arrived
+    // Vertex positions in the current rotation, for screen-space picking
+    ScreenProjector m_screenProjector;
 
     // Alternative trackpad controls
     bool m_isZKeyPressed;    // Z key for zoom mode
@@ -767,45 +872,65 @@ private:
     bool m_isLeftDragging;   // left mouse dragging state
     glm::vec2 m_zoomAnchorNdc{0.0f, 0.0f};
     bool m_drawFacetNormals; // toggle for facet normals debug
+    float m_weldEpsilon;     // vertex welding distance; negative = welding off
+    float m_featureAngle;    // feature edge threshold in degrees
+    bool m_useMeshCache;     // reopen meshes from the on-disk cache when valid
+    MeshRenderOptions m_renderOptions; // e.g. quantized vertex buffers
+    bool m_continuousRendering; // redraw every frame, not only on changes
+    bool m_needsRedraw;         // the view changed since the last frame
+    bool m_glDebug = false;  // validate GL calls (slower); only with --gl-debug
     
     // Light rotation controls
     float m_lightRotationX;  // light rotation around X axis (degrees)
     float m_lightRotationY;  // light rotation around Y axis (degrees)
 
+    // Start loading `path` in the background; pollLoader() shows it once ready
     bool loadGeometry(const std::string& path) {
-        std::unique_ptr<Mesh> mesh;
-        
-        // Create console progress for standalone mySTLviewer
-        ConsoleProgress consoleProgress;
-        Progress_abstract* progress = &consoleProgress;
+        GeometryLoadOptions options;
+        options.weldEpsilon = m_weldEpsilon;
+        options.featureAngle = m_featureAngle;
+        options.useMeshCache = m_useMeshCache;
+        std::cout << "Loading " << path << std::endl;
+        m_loader.start(path, options, m_renderOptions);
+        m_loadingTitle.clear();
+        return true;
+    }
+
+    // Upload a finished background load, or show the progress of a running one
+    void pollLoader() {
+        if (!m_loader.isLoading()) {
+            return;
+        }
+        std::unique_ptr<MeshRenderData> data;
+        if (!m_loader.poll(data)) {
+            const AsyncProgress& progress = m_loader.progress();
+            std::string title = "STL Viewer - Loading " +
+                std::filesystem::path(m_loader.path()).filename().string() + ": " + progress.getMessage() +
+                " " + std::to_string(static_cast<int>(progress.getProgress() * 100.0f + 0.5f)) + "% (ESC to cancel)";
+            if (title != m_loadingTitle) {
+                m_loadingTitle = title;
+                SDL_SetWindowTitle(m_window, title.c_str());
+            }
+            return;
+        }
         
-        // Determine file type and load accordingly
-        try {
-            size_t dotPos = path.find_last_of('.');
-            if (dotPos != std::string::npos) {
-                std::string ext = path.substr(dotPos);
-                if (ext == ".xml" || ext == ".XML") {
-                    mesh = XMLLoader::load(path, progress);
-                } else if (ext == ".zip" || ext == ".ZIP") {
-                    // Zip files should contain XML, use XMLLoader
-                    mesh = XMLLoader::load(path, progress);
-                } else {
-                    mesh = STLLoader::load(path, progress);
-                }
+        SDL_SetWindowTitle(m_window, "STL Viewer");
+        if (!data) {
+            if (m_loader.wasCancelled()) {
+                std::cout << "Loading cancelled: " << m_loader.path() << std::endl;
             } else {
-                // No extension, try STL
-                mesh = STLLoader::load(path, progress);
+                std::cerr << "Failed to load file: " << m_loader.path() << std::endl;
             }
-        } catch (...) {
-            // Handle any exceptions during loading
-            mesh = nullptr;
+            // Nothing to show (the startup load failed): quit as the synchronous load used to
+            if (!m_renderer.getMesh()) {
+                m_exitCode = m_loader.wasCancelled() ? 0 : 1;
+                m_running = false;
+            }
+            return;
         }
         
-        if (!mesh) {
-            std::cerr << "Failed to load file: " << path << std::endl;
-            return false;
-        }
-        m_renderer.setMesh(std::move(mesh));
+        m_renderer.setPreparedMesh(std::move(data));
+        m_needsRedraw = true;
         if (m_renderer.getMesh()) {
             float extent = m_renderer.getMesh()->getMaxExtent();
             m_zoom = extent * 1.5f;
@@ -814,7 +939,7 @@ private:
             m_showPivotAxes = false;
             m_displayPivotModel = m_renderer.getMesh()->getCenter();
         }
-        return true;
+        m_screenProjector.clear(); // holds the previous mesh's positions
     }
 
     bool openFileDialogAndLoad(bool required) {
@@ -851,86 +976,81 @@ private:
         Uint64 t0 = SDL_GetTicksNS();
         if (!m_renderer.getMesh()) return;
         int width = 1, height = 1;
-        SDL_GetWindowSize(m_window, &width, &height);
-        float aspect = static_cast<float>(width) / static_cast<float>(height);
-        float orthoSize = m_zoom;
-        float maxExtent = m_renderer.getMesh() ? m_renderer.getMesh()->getMaxExtent() : 100.0f;
-        glm::mat4 projection = glm::ortho(
-            -orthoSize * aspect, orthoSize * aspect,
-            -orthoSize, orthoSize,
-            -maxExtent * 10.0f, maxExtent * 10.0f);
-        glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(m_pan.x, m_pan.y, 0.0f));
+        glm::mat4 projection, view, model;
+        cameraMatrices(width, height, projection, view, model);
 
-        // Model matrix BEFORE changing pivot (respect current state)
-        glm::mat4 modelOld = glm::mat4(1.0f);
-        glm::vec3 center = m_renderer.getMesh()->getCenter();
-        if (m_pivotActive) {
-            glm::vec3 pPrime = m_pivotModel - center;
-            modelOld = glm::translate(modelOld, pPrime);
-            modelOld = glm::rotate(modelOld, glm::radians(m_rotationX), glm::vec3(1.0f, 0.0f, 0.0f));
-            modelOld = glm::rotate(modelOld, glm::radians(m_rotationY), glm::vec3(0.0f, 1.0f, 0.0f));
-            modelOld = glm::translate(modelOld, -pPrime);
-            modelOld = glm::translate(modelOld, -center);
-        } else {
-            modelOld = glm::rotate(modelOld, glm::radians(m_rotationX), glm::vec3(1.0f, 0.0f, 0.0f));
-            modelOld = glm::rotate(modelOld, glm::radians(m_rotationY), glm::vec3(0.0f, 1.0f, 0.0f));
-            modelOld = glm::translate(modelOld, -center);
+        if (m_pickingBackend == PickingBackend::GpuIdBuffer) {
+            // Finished by pollGpuPick() once the ID buffer has been read back
+            if (m_renderer.requestPick(projection, view, model, mouseX, mouseY, width, height)) {
+                m_gpuPickStart = t0;
+                m_gpuPickCursor = glm::vec2(static_cast<float>(mouseX), static_cast<float>(mouseY));
+                m_gpuPickMvp = projection * view * model;
+                m_gpuPickViewport = glm::vec2(static_cast<float>(width), static_cast<float>(height));
+                m_gpuPickReleased = false;
+            }
+            return;
         }
-        const auto& verts = m_renderer.getMesh()->vertices;
-        float bestDist2 = std::numeric_limits<float>::infinity();
+
         glm::vec3 bestPos(0.0f);
-        // Use cached screen positions
-#ifdef HAVE_OPENMP
-        if (m_useOpenMP) {
-            #pragma omp parallel
-            {
-                float localBest = std::numeric_limits<float>::infinity();
-                glm::vec3 localPos(0.0f);
-                #pragma omp for nowait
-                for (int i = 0; i < static_cast<int>(verts.size()); ++i) {
-                    const glm::vec2 sc = (i < (int)m_screenCache.size() ? m_screenCache[i] : glm::vec2(std::numeric_limits<float>::infinity()));
-                    float dx = sc.x - mouseX;
-                    float dy = sc.y - mouseY;
-                    float d2 = dx*dx + dy*dy;
-                    if (d2 < localBest) {
-                        localBest = d2;
-                        localPos = verts[i].position;
-                    }
-                }
-                #pragma omp critical
-                {
-                    if (localBest < bestDist2) {
-                        bestDist2 = localBest;
-                        bestPos = localPos;
-                    }
-                }
-            }
-        } else
-#endif
-        {
-            for (int i = 0; i < static_cast<int>(verts.size()); ++i) {
-                const glm::vec2 sc = (i < (int)m_screenCache.size() ? m_screenCache[i] : glm::vec2(std::numeric_limits<float>::infinity()));
-                float dx = sc.x - mouseX;
-                float dy = sc.y - mouseY;
-                float d2 = dx*dx + dy*dy;
+        const bool picked = m_pickingBackend == PickingBackend::RayCast
+            ? pickByRayCast(projection * view * model, mouseX, mouseY, width, height, bestPos)
+            : pickFromScreenCache(projection * view * model, mouseX, mouseY, width, height, bestPos);
+        std::cout << "Picked in " << (SDL_GetTicksNS() - t0) / 1000 << " us [" << pickingBackendName() << "]" << std::endl;
+        setPivot(picked, bestPos);
+    }
+
+    // Take the GPU pick result if it has arrived: the vertex of the picked
+    // triangle that is nearest the cursor on screen
+    void pollGpuPick() {
+        unsigned int triangle = Renderer::kNoTriangle;
+        if (!m_renderer.pollPick(triangle) || !m_renderer.getMesh()) return;
+        std::cout << "Picked in " << (SDL_GetTicksNS() - m_gpuPickStart) / 1000 << " us [" << pickingBackendName()
+                  << "]" << std::endl;
+
+        const Mesh* mesh = m_renderer.getMesh();
+        glm::vec3 bestPos(0.0f);
+        if (triangle != Renderer::kNoTriangle) {
+            // Projected as at the click, where the cursor position was taken
+            const glm::mat4& mvp = m_gpuPickMvp;
+            const float width = m_gpuPickViewport.x;
+            const float height = m_gpuPickViewport.y;
+            float bestDist2 = std::numeric_limits<float>::infinity();
+            for (int k = 0; k < 3; ++k) {
+                const glm::vec3& p = mesh->vertices[mesh->triangleIndices[3 * size_t(triangle) + k]].position;
+                const glm::vec4 clip = mvp * glm::vec4(p, 1.0f);
+                const glm::vec2 screen((clip.x * 0.5f + 0.5f) * width, (0.5f - clip.y * 0.5f) * height);
+                const float d2 = glm::dot(screen - m_gpuPickCursor, screen - m_gpuPickCursor);
                 if (d2 < bestDist2) {
                     bestDist2 = d2;
-                    bestPos = verts[i].position; // model-space
+                    bestPos = p;
                 }
             }
         }
-        if (!(bestDist2 < std::numeric_limits<float>::infinity())) {
-            return;
+        setPivot(triangle != Renderer::kNoTriangle, bestPos);
+        // A click shorter than the read-back: the same net effect as with the
+        // other backends, which set the pivot on button down and clear it on button up
+        if (m_gpuPickReleased) {
+            m_gpuPickReleased = false;
+            clearPivot();
         }
+        m_needsRedraw = true;
+    }
+
+    // Rotate around `position` from now on (the scene center if !picked),
+    // shifting the pan so that nothing moves on screen
+    void setPivot(bool picked, const glm::vec3& bestPos) {
+        // Model matrix BEFORE changing pivot (respect current state)
+        int width = 1, height = 1;
+        glm::mat4 projection, view, modelOld;
+        cameraMatrices(width, height, projection, view, modelOld);
+        const glm::vec3 center = m_renderer.getMesh()->getCenter();
 
         m_displayPivotModel = center;
         m_showPivotAxes = true;
 
-        // If too far from any vertex, rotate around the default scene center.
-        const float maxPixelDist = 100.0f;
-        if (bestDist2 > maxPixelDist * maxPixelDist) {
+        // Nothing under the cursor: rotate around the default scene center
+        if (!picked) {
             m_pivotActive = false;
-            m_cacheValid = false;
             return;
         }
 
@@ -959,82 +1079,98 @@ private:
         m_pivotModel = bestPos;
         m_displayPivotModel = bestPos;
         m_pivotActive = true;
-        m_cacheValid = false;
-        (void)t0;
     }
 
-    void computeScreenCache() {
-        Uint64 t0 = SDL_GetTicksNS();
-        m_cacheValid = false;
-        m_screenCache.clear();
-        if (!m_renderer.getMesh()) return;
-        int width = 1, height = 1;
-        SDL_GetWindowSize(m_window, &width, &height);
-        float aspect = static_cast<float>(width) / static_cast<float>(height);
-        float orthoSize = m_zoom;
-        float maxExtent = m_renderer.getMesh() ? m_renderer.getMesh()->getMaxExtent() : 100.0f;
-        glm::mat4 projection = glm::ortho(
-            -orthoSize * aspect, orthoSize * aspect,
-            -orthoSize, orthoSize,
-            -maxExtent * 10.0f, maxExtent * 10.0f);
-        glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(m_pan.x, m_pan.y, 0.0f));
+    const char* pickingBackendName() const {
+        switch (m_pickingBackend) {
+            case PickingBackend::RayCast: return "ray cast";
+            case PickingBackend::ScreenCache: return "screen cache";
+            default: return "GPU ID buffer";
+        }
+    }
 
-        glm::mat4 model = glm::mat4(1.0f);
-        if (m_renderer.getMesh()) {
-            glm::vec3 center = m_renderer.getMesh()->getCenter();
-            if (m_pivotActive) {
-                glm::vec3 pPrime = m_pivotModel - center;
-                model = glm::translate(model, pPrime);
-                model = glm::rotate(model, glm::radians(m_rotationX), glm::vec3(1.0f, 0.0f, 0.0f));
-                model = glm::rotate(model, glm::radians(m_rotationY), glm::vec3(0.0f, 1.0f, 0.0f));
-                model = glm::translate(model, -pPrime);
-                model = glm::translate(model, -center);
-            } else {
-                model = glm::rotate(model, glm::radians(m_rotationX), glm::vec3(1.0f, 0.0f, 0.0f));
-                model = glm::rotate(model, glm::radians(m_rotationY), glm::vec3(0.0f, 1.0f, 0.0f));
-                model = glm::translate(model, -center);
+    // Cast the ray under the cursor through the mesh and take the vertex of the
+    // first triangle hit that is nearest to the hit point. `mvp` maps model
+    // space to clip space for the current view.
+    bool pickByRayCast(const glm::mat4& mvp, int mouseX, int mouseY, int width, int height, glm::vec3& position) {
+        const Mesh* mesh = m_renderer.getMesh();
+        const glm::mat4 inverseMvp = glm::inverse(mvp);
+        const float ndcX = 2.0f * mouseX / width - 1.0f;
+        const float ndcY = 1.0f - 2.0f * mouseY / height;
+        const glm::vec4 nearPoint = inverseMvp * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+        const glm::vec4 farPoint = inverseMvp * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+        const glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+        const glm::vec3 direction = glm::vec3(farPoint) / farPoint.w - origin;
+
+        MeshBVH::Hit hit;
+        if (!m_renderer.getBVH().raycast(*mesh, origin, direction, hit)) {
+            return false;
+        }
+        const glm::vec3 hitPoint = origin + hit.t * direction;
+        const unsigned int* triangle = mesh->triangleIndices.data() + 3 * size_t(hit.triangle);
+        float bestDist2 = std::numeric_limits<float>::infinity();
+        for (int k = 0; k < 3; ++k) {
+            const glm::vec3& p = mesh->vertices[triangle[k]].position;
+            const float d2 = glm::dot(p - hitPoint, p - hitPoint);
+            if (d2 < bestDist2) {
+                bestDist2 = d2;
+                position = p;
             }
         }
+        return true;
+    }
 
-        const auto& verts = m_renderer.getMesh()->vertices;
-        m_screenCache.resize(verts.size());
-#ifdef HAVE_OPENMP
-        if (m_useOpenMP) {
-            #pragma omp parallel for
-            for (int i = 0; i < static_cast<int>(verts.size()); ++i) {
-                const auto& v = verts[i];
-                glm::vec4 clip = projection * view * model * glm::vec4(v.position, 1.0f);
-                if (clip.w == 0.0f) { m_screenCache[i] = glm::vec2(std::numeric_limits<float>::infinity()); continue; }
-                glm::vec3 ndc = glm::vec3(clip) / clip.w;
-                float sx = (ndc.x * 0.5f + 0.5f) * width;
-                float sy = (1.0f - (ndc.y * 0.5f + 0.5f)) * height;
-                m_screenCache[i] = glm::vec2(sx, sy);
-            }
-        } else
-#endif
-        {
-            for (size_t i = 0; i < verts.size(); ++i) {
-                const auto& v = verts[i];
-                glm::vec4 clip = projection * view * model * glm::vec4(v.position, 1.0f);
-                if (clip.w == 0.0f) { m_screenCache[i] = glm::vec2(std::numeric_limits<float>::infinity()); continue; }
-                glm::vec3 ndc = glm::vec3(clip) / clip.w;
-                float sx = (ndc.x * 0.5f + 0.5f) * width;
-                float sy = (1.0f - (ndc.y * 0.5f + 0.5f)) * height;
-                m_screenCache[i] = glm::vec2(sx, sy);
-            }
+    // Nearest projected vertex within 100 pixels of the cursor, hidden or not.
+    // Only searches unless the model was rotated since the screen cache was
+    // last brought up to date; panning and zooming need no new projection.
+    bool pickFromScreenCache(const glm::mat4& mvp, int mouseX, int mouseY, int width, int height, glm::vec3& position) {
+        if (m_screenProjector.empty()) {
+            m_screenProjector.setMesh(*m_renderer.getMesh());
+        }
+        const glm::vec2 cursor(static_cast<float>(mouseX), static_cast<float>(mouseY));
+        const ScreenProjector::Nearest nearest =
+            m_screenProjector.nearest(mvp, modelRotation(), width, height, cursor, m_useOpenMP);
+
+        // If too far from any vertex, rotate around the default scene center.
+        const float maxPixelDist = 100.0f;
+        if (!(nearest.distance2 <= maxPixelDist * maxPixelDist)) {
+            return false;
         }
-        m_cacheValid = true;
-    double ms = (SDL_GetTicksNS() - t0) / 1.0e6;
+        position = m_renderer.getMesh()->vertices[nearest.vertex].position;
+        return true;
+    }
+
+    // Rotation part of the model matrix, the same for every pivot
+    glm::mat3 modelRotation() const {
+        glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), glm::radians(m_rotationX), glm::vec3(1.0f, 0.0f, 0.0f));
+        rotation = glm::rotate(rotation, glm::radians(m_rotationY), glm::vec3(0.0f, 1.0f, 0.0f));
+        return glm::mat3(rotation);
+    }
+
+    // Bring the screen cache up to date with the current rotation, so the next
+    // pick only searches. Does nothing unless the rotation or the mesh changed.
+    void computeScreenCache() {
+        if (!m_renderer.getMesh()) return;
+        Uint64 t0 = SDL_GetTicksNS();
+        if (m_screenProjector.empty()) {
+            m_screenProjector.setMesh(*m_renderer.getMesh());
+        }
+        if (!m_screenProjector.rotate(modelRotation(), m_useOpenMP)) {
+            return;
+        }
+        double ms = (SDL_GetTicksNS() - t0) / 1.0e6;
 #ifdef HAVE_OPENMP
-    bool usedOMP = m_useOpenMP;
+        bool usedOMP = m_useOpenMP;
 #else
-    bool usedOMP = false;
+        bool usedOMP = false;
 #endif
-    std::cout << "Screen cache refreshed in " << (int)ms << " ms for "
-          << verts.size() << " vertices" << (usedOMP ? " [OpenMP]" : "") << std::endl;
+        std::cout << "Screen cache refreshed in " << ms << " ms for " << m_screenProjector.vertexCount()
+                  << " vertices [" << ScreenProjector::instructionSet() << (usedOMP ? ", OpenMP" : "") << "]"
+                  << std::endl;
     }
 
-    void drawPivotAxes(const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model) {
+    // Uses the camera render() just stored in the frame uniform buffer
+    void drawPivotAxes(const glm::mat4& model) {
         if (!m_axesProgram) return;
         // Compute world-space pivot position and axis directions from model matrix
         glm::vec4 worldPivot4 = model * glm::vec4(m_displayPivotModel, 1.0f);
@@ -1066,10 +1202,6 @@ private:
         GLboolean wasDepth = glIsEnabled(GL_DEPTH_TEST);
         glDisable(GL_DEPTH_TEST);
         glUseProgram(m_axesProgram);
-        GLint projLoc = glGetUniformLocation(m_axesProgram, "projection");
-        GLint viewLoc = glGetUniformLocation(m_axesProgram, "view");
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
         glBindVertexArray(m_axesVAO);
         glLineWidth(2.0f);
         glDrawArrays(GL_LINES, 0, 6);
@@ -1078,10 +1210,271 @@ private:
     }
 };
 
+// Headless batch mode (--thumbnails): one PNG per file, no window or file dialog.
+// Returns the process exit code.
+int runThumbnails(const std::vector<std::string>& files, const ThumbnailOptions& options,
+                  const GeometryLoadOptions& loadOptions, const MeshRenderOptions& renderOptions, bool glDebug) {
+    if (files.empty()) {
+        std::cerr << "No files to render (pass them as arguments or with --list=FILE)" << std::endl;
+        return 1;
+    }
+    OffscreenContext context;
+    if (!context.create(glDebug)) {
+        std::cerr << "Failed to create an offscreen OpenGL context" << std::endl;
+        return 1;
+    }
+    std::cout << "Rendering " << files.size() << " thumbnails of " << options.width << "x" << options.height
+              << " into " << options.outputDirectory << " (" << context.backendName() << ")" << std::endl;
+    ThumbnailRenderer thumbnails;
+    if (!thumbnails.initialize(options)) {
+        return 1;
+    }
+    thumbnails.setDebugValidation(glDebug);
+    return thumbnails.renderFiles(files, loadOptions, renderOptions) == files.size() ? 0 : 1;
+}
+
+// Welding check (--self-test-weld) on polygon facets: a repeated vertex inside
+// an n-gon, a triangle that collapses, a facet whose last vertex welds onto its
+// first, each followed by another facet, since the facet offsets are compacted
+// in place. Returns the process exit code.
+int runWeldSelfTest() {
+    Mesh mesh;
+    const float positions[][3] = {
+        {0, 0, 0}, {1, 0, 0}, {2, 1, 0}, {2, 1, 0}, {0, 2, 0},   // pentagon, v3 == v2
+        {5, 0, 0}, {6, 0, 0}, {5, 1, 0},                         // triangle
+        {9, 0, 0}, {9, 0, 0}, {9, 1, 0},                         // triangle, v9 == v8: dropped
+        {12, 0, 0}, {13, 0, 0}, {13, 1, 0}, {12, 0, 0},          // quad, v14 == v11
+        {15, 0, 0}, {16, 0, 0}, {16, 1, 0}, {15, 1, 0}, {15, 2, 0} // pentagon, untouched
+    };
+    for (const auto& p : positions) {
+        mesh.vertices.push_back({glm::vec3(p[0], p[1], p[2]), glm::vec3(0.0f, 0.0f, 1.0f)});
+    }
+    mesh.facets.add({0, 1, 2, 3, 4});
+    mesh.facets.add({5, 6, 7});
+    mesh.facets.add({8, 9, 10});
+    mesh.facets.add({11, 12, 13, 14});
+    mesh.facets.add({15, 16, 17, 18, 19});
+    mesh.calculateBounds();
+
+    const MeshWelder::Result result = MeshWelder::weld(mesh, 0.0f);
+    // Surviving vertices keep their order: 0 1 2 4 5 6 7 8 10 11 12 13 15 ..
+    const std::vector<std::vector<unsigned int>> expected = {
+        {0, 1, 2, 3}, {4, 5, 6}, {9, 10, 11}, {12, 13, 14, 15, 16}
+    };
+    bool passed = result.verticesRemoved == 3 && result.facetsRemoved == 1 &&
+                  mesh.vertices.size() == 17 && mesh.facets.size() == expected.size();
+    for (size_t f = 0; passed && f < expected.size(); ++f) {
+        const FacetView facet = mesh.facets[f];
+        passed = std::vector<unsigned int>(facet.begin(), facet.end()) == expected[f];
+    }
+    if (!passed) {
+        std::cout << "  " << result.verticesRemoved << " vertices and " << result.facetsRemoved
+                  << " facets removed, facets:";
+        for (const FacetView facet : mesh.facets) {
+            std::cout << " {";
+            for (unsigned int index : facet) std::cout << " " << index;
+            std::cout << " }";
+        }
+        std::cout << std::endl;
+    }
+    std::cout << "Weld self-test: " << (passed ? "passed" : "FAILED") << std::endl;
+    return passed ? 0 : 1;
+}
+
+// GPU picking check (--self-test-pick) that needs no window, so CI can run it
+// on a software rasterizer (LIBGL_ALWAYS_SOFTWARE=1). Two quads side by side
+// in front of a larger one are picked through an offscreen context at pixels
+// whose answer is known. Returns the process exit code.
+int runPickSelfTest(bool glDebug) {
+    OffscreenContext context;
+    if (!context.create(glDebug)) {
+        std::cerr << "Failed to create an offscreen OpenGL context" << std::endl;
+        return 1;
+    }
+    Renderer renderer;
+    if (!renderer.initialize()) {
+        std::cerr << "Failed to initialize renderer" << std::endl;
+        return 1;
+    }
+    renderer.setDebugValidation(glDebug);
+
+    // Counter-clockwise seen from +z: left and right quads at z = 0, a taller
+    // one at z = -1 behind the left quad that shows above and below it
+    auto mesh = std::make_unique<Mesh>();
+    auto addQuad = [&](float x0, float y0, float x1, float y1, float z) {
+        const unsigned int first = static_cast<unsigned int>(mesh->vertices.size());
+        for (const glm::vec2& corner : {glm::vec2(x0, y0), glm::vec2(x1, y0), glm::vec2(x1, y1), glm::vec2(x0, y1)}) {
+            mesh->vertices.push_back({glm::vec3(corner.x, corner.y, z), glm::vec3(0.0f, 0.0f, 1.0f)});
+        }
+        mesh->facets.add({first, first + 1, first + 2, first + 3});
+    };
+    addQuad(-2.0f, -0.75f, -0.5f, 0.75f, 0.0f);
+    addQuad(0.5f, -0.75f, 2.0f, 0.75f, 0.0f);
+    addQuad(-2.5f, -1.25f, -0.25f, 1.25f, -1.0f);
+    mesh->calculateBounds();
+    renderer.setMesh(std::move(mesh));
+    const Mesh* picked = renderer.getMesh();
+
+    // 96x64 pixels onto x in [-3, 3], y in [-2, 2]: 16 pixels per unit
+    const int width = 96, height = 64;
+    const glm::mat4 projection = glm::ortho(-3.0f, 3.0f, -2.0f, 2.0f, 0.1f, 10.0f);
+    const glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f));
+    const glm::mat4 model(1.0f);
+
+    // Pixel, and the quad expected there (its depth and side of the y axis), or none
+    struct Case {
+        const char* name;
+        int x, y;
+        bool hit;
+        float z;
+        bool left;
+    };
+    const Case cases[] = {
+        {"left quad", 28, 32, true, 0.0f, true},
+        {"right quad", 68, 32, true, 0.0f, false},
+        {"quad behind", 28, 14, true, -1.0f, true},
+        {"background", 48, 60, false, 0.0f, false},
+    };
+    int failures = 0;
+    for (const Case& test : cases) {
+        unsigned int triangle = Renderer::kNoTriangle;
+        bool done = false;
+        if (renderer.requestPick(projection, view, model, test.x, test.y, width, height)) {
+            const Uint64 deadline = SDL_GetTicks() + 5000;
+            while (!(done = renderer.pollPick(triangle)) && SDL_GetTicks() < deadline) {
+                SDL_Delay(1);
+            }
+        }
+        bool passed = false;
+        if (!done) {
+            std::cout << "  " << test.name << ": no result" << std::endl;
+        } else if (triangle == Renderer::kNoTriangle) {
+            passed = !test.hit;
+            std::cout << "  " << test.name << ": nothing" << (passed ? "" : ", FAILED") << std::endl;
+        } else if (3 * size_t(triangle) + 2 >= picked->triangleIndices.size()) {
+            std::cout << "  " << test.name << ": triangle " << triangle << " out of range, FAILED" << std::endl;
+        } else {
+            glm::vec3 centroid(0.0f);
+            for (int k = 0; k < 3; ++k) {
+                centroid += picked->vertices[picked->triangleIndices[3 * size_t(triangle) + k]].position / 3.0f;
+            }
+            passed = test.hit && centroid.z == test.z && (centroid.x < 0.0f) == test.left;
+            std::cout << "  " << test.name << ": triangle " << triangle << " at z = " << centroid.z
+                      << (passed ? "" : ", FAILED") << std::endl;
+        }
+        failures += passed ? 0 : 1;
+    }
+    std::cout << "GPU pick self-test (" << context.backendName() << "): "
+              << (failures == 0 ? "passed" : "FAILED") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
 int main(int argc, char* argv[]) {
-    // When launched without arguments (e.g., double-clicked in Finder),
-    // change CWD to the executable's directory so shaders can be found
-    if (argc < 2 && argv[0]) {
+    std::vector<std::string> files;
+    float weldEpsilon = -1.0f;
+    bool useMeshCache = true;
+    bool meshCacheRequested = false; // --cache; batch mode leaves the cache alone otherwise
+    float featureAngle = EdgeExtractor::kDefaultFeatureAngle;
+    MeshRenderOptions renderOptions;
+    bool glDebug = false;
+    bool continuousRendering = false;
+    bool thumbnails = false;
+    bool pickSelfTest = false;
+    bool weldSelfTest = false;
+    ThumbnailOptions thumbnailOptions;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--weld") {
+            weldEpsilon = 0.0f;
+        } else if (arg.rfind("--weld=", 0) == 0) {
+            weldEpsilon = std::max(0.0f, std::strtof(arg.c_str() + 7, nullptr));
+        } else if (arg == "--no-cache") {
+            useMeshCache = false;
+        } else if (arg == "--cache") {
+            meshCacheRequested = true;
+        } else if (arg.rfind("--feature-angle=", 0) == 0) {
+            featureAngle = std::min(180.0f, std::max(0.0f, std::strtof(arg.c_str() + 16, nullptr)));
+        } else if (arg == "--gl-debug") {
+            glDebug = true;
+        } else if (arg == "--continuous") {
+            continuousRendering = true;
+        } else if (arg == "--no-lod") {
+            renderOptions.levelOfDetail = false;
+        } else if (arg == "--quantize") {
+            renderOptions.quantize = true;
+        } else if (arg.rfind("--quantize=", 0) == 0) {
+            renderOptions.quantize = true;
+            renderOptions.quantizeTolerance = std::max(0.0f, std::strtof(arg.c_str() + 11, nullptr));
+        } else if (arg == "--thumbnails") {
+            thumbnails = true;
+        } else if (arg.rfind("--thumbnails=", 0) == 0) {
+            thumbnails = true;
+            thumbnailOptions.outputDirectory = arg.substr(13);
+        } else if (arg == "--self-test-pick") {
+            pickSelfTest = true;
+        } else if (arg == "--self-test-weld") {
+            weldSelfTest = true;
+        } else if (arg.rfind("--size=", 0) == 0) {
+            int width = 0, height = 0;
+            if (std::sscanf(arg.c_str() + 7, "%dx%d", &width, &height) == 2 && width > 0 && height > 0) {
+                thumbnailOptions.width = width;
+                thumbnailOptions.height = height;
+            } else {
+                std::cerr << "Ignoring " << arg << " (expected --size=WIDTHxHEIGHT)" << std::endl;
+            }
+        } else if (arg.rfind("--view=", 0) == 0) {
+            float rotationX = 0.0f, rotationY = 0.0f;
+            if (std::sscanf(arg.c_str() + 7, "%f,%f", &rotationX, &rotationY) == 2) {
+                thumbnailOptions.rotationX = rotationX;
+                thumbnailOptions.rotationY = rotationY;
+            } else {
+                std::cerr << "Ignoring " << arg << " (expected --view=DEGREES_X,DEGREES_Y)" << std::endl;
+            }
+        } else if (arg == "--wireframe") {
+            thumbnailOptions.drawWireframe = true;
+        } else if (arg == "--wireframe=features") {
+            thumbnailOptions.drawWireframe = true;
+            thumbnailOptions.featureEdgesOnly = true;
+        } else if (arg == "--no-solid") {
+            thumbnailOptions.drawSolid = false;
+        } else if (arg.rfind("--jobs=", 0) == 0) {
+            thumbnailOptions.loaderThreads =
+                static_cast<unsigned int>(std::max(0L, std::strtol(arg.c_str() + 7, nullptr, 10)));
+        } else if (arg.rfind("--list=", 0) == 0) {
+            // One path per line
+            std::ifstream list(arg.substr(7));
+            if (!list) {
+                std::cerr << "Cannot read file list " << arg.substr(7) << std::endl;
+                return 1;
+            }
+            std::string line;
+            while (std::getline(list, line)) {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (!line.empty()) files.push_back(line);
+            }
+        } else {
+            files.push_back(arg);
+        }
+    }
+    
+    if (thumbnails) {
+        // Absolute paths, as the working directory may change below
+        for (std::string& file : files) {
+            file = std::filesystem::absolute(file).string();
+        }
+        thumbnailOptions.outputDirectory = std::filesystem::absolute(thumbnailOptions.outputDirectory).string();
+    }
+    std::string stlFile = (!thumbnails && !files.empty()) ? files.front() : std::string();
+    for (size_t i = 1; !thumbnails && i < files.size(); ++i) {
+        std::cerr << "Ignoring extra argument: " << files[i] << std::endl;
+    }
+    
+    // When launched without a file (e.g., double-clicked in Finder), or in
+    // batch mode away from the build directory, change CWD to the
+    // executable's directory so shaders can be found
+    const bool useExecutableDirectory = (thumbnails || pickSelfTest) ? !std::filesystem::exists("shaders")
+                                                                      : stlFile.empty();
+    if (useExecutableDirectory && argv[0]) {
         std::filesystem::path exePath(argv[0]);
         std::filesystem::path exeDir = exePath.parent_path();
         if (!exeDir.empty()) {
@@ -1096,14 +1489,25 @@ int main(int argc, char* argv[]) {
         }
     }
     
-    std::string stlFile;
-    if (argc >= 2) {
-        stlFile = argv[1];
+    if (weldSelfTest) {
+        return runWeldSelfTest();
+    }
+    if (pickSelfTest) {
+        return runPickSelfTest(glDebug);
+    }
+    if (thumbnails) {
+        GeometryLoadOptions loadOptions;
+        loadOptions.weldEpsilon = weldEpsilon;
+        // Every file is loaded once, so caching would only write a triangulated
+        // copy of each input into the cache directory
+        loadOptions.useMeshCache = useMeshCache && meshCacheRequested;
+        loadOptions.featureAngle = featureAngle;
+        return runThumbnails(files, thumbnailOptions, loadOptions, renderOptions, glDebug);
     }
     
     // Display controls
     std::cout << "\nControls:" << std::endl;
-    std::cout << "  Right Mouse + Drag: Rotate around closest vertex under cursor, or scene center if none is nearby" << std::endl;
+    std::cout << "  Right Mouse + Drag: Rotate around the surface vertex under the cursor, or scene center if none" << std::endl;
     std::cout << "  Middle Mouse + Drag: Pan view" << std::endl;
     std::cout << "  Mouse Wheel: Zoom in/out" << std::endl;
     std::cout << "" << std::endl;
@@ -1113,27 +1517,35 @@ int main(int argc, char* argv[]) {
     std::cout << "" << std::endl;
     std::cout << "  V: Toggle VSync" << std::endl;
     std::cout << "  M: Toggle OpenMP picking" << std::endl;
+    std::cout << "  P: Cycle picking between ray cast, screen cache and GPU ID buffer" << std::endl;
     std::cout << "  C: Toggle back-face culling" << std::endl;
     std::cout << "  N: Toggle normals debug (facet=magenta, triangle=cyan)" << std::endl;
     std::cout << "  W: Toggle wireframe overlay (black)" << std::endl;
+    std::cout << "  F: Toggle wireframe between all edges and feature edges only" << std::endl;
     std::cout << "  S: Toggle solid fill" << std::endl;
     std::cout << "     When both are ON, wireframe draws on top of solid." << std::endl;
     std::cout << "  L: Hold + right drag to rotate light source" << std::endl;
     std::cout << "  R: Reset view" << std::endl;
-    std::cout << "  Q/ESC: Quit" << std::endl;
+    std::cout << "  Q/ESC: Quit (ESC cancels a load in progress)" << std::endl;
     
     Application app;
+    app.setWeldEpsilon(weldEpsilon);
+    app.setFeatureAngle(featureAngle);
+    app.setMeshCacheEnabled(useMeshCache);
+    app.setRenderOptions(renderOptions);
+    app.setContinuousRendering(continuousRendering);
+    if (glDebug) {
+        app.setGLDebug(true);
+    }
     
     if (!app.initialize(stlFile)) {
         // If user cancelled the file dialog, treat it as a normal exit
-        if (argc < 2) {
+        if (stlFile.empty()) {
             return 0;
         }
         std::cerr << "Failed to initialize application" << std::endl;
         return 1;
     }
     
-    app.run();
-    
-    return 0;
+    return app.run();
 }
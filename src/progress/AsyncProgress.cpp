@@ -0,0 +1,31 @@
+#include "AsyncProgress.h"
+
+AsyncProgress::AsyncProgress()
+    : progress_(0.0f)
+    , cancelled_(false)
+{
+}
+
+void AsyncProgress::setProgress(float progress) {
+    if (progress < 0.0f) progress = 0.0f;
+    if (progress > 1.0f) progress = 1.0f;
+
+    progress_ = progress;
+}
+
+void AsyncProgress::setMessage(const std::string& message) {
+    std::lock_guard<std::mutex> lock(messageMutex_);
+    message_ = message;
+}
+
+void AsyncProgress::reset() {
+    progress_ = 0.0f;
+    cancelled_ = false;
+    std::lock_guard<std::mutex> lock(messageMutex_);
+    message_.clear();
+}
+
+std::string AsyncProgress::getMessage() const {
+    std::lock_guard<std::mutex> lock(messageMutex_);
+    return message_;
+}
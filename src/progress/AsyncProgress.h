@@ -0,0 +1,44 @@
+#ifndef STLVIEWER_ASYNC_PROGRESS_H
+#define STLVIEWER_ASYNC_PROGRESS_H
+
+#include "Progress_abstract.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+
+// Progress shared between a worker thread that reports it and the UI thread
+// that displays it and may cancel the work. All methods are thread-safe.
+class AsyncProgress : public Progress_abstract {
+public:
+    AsyncProgress();
+    virtual ~AsyncProgress() = default;
+
+    // Set progress value (0.0 to 1.0)
+    void setProgress(float progress) override;
+
+    // Set message text
+    void setMessage(const std::string& message) override;
+
+    // True once cancel() has been called
+    bool isCancelled() const override { return cancelled_.load(); }
+
+    // Ask the worker to stop at its next cancellation check
+    void cancel() { cancelled_ = true; }
+
+    // Clear progress, message and cancellation before starting new work
+    void reset();
+
+    // Get current progress
+    float getProgress() const { return progress_.load(); }
+
+    // Get current message
+    std::string getMessage() const;
+
+private:
+    std::atomic<float> progress_;
+    std::atomic<bool> cancelled_;
+    mutable std::mutex messageMutex_;
+    std::string message_;
+};
+
+#endif // STLVIEWER_ASYNC_PROGRESS_H